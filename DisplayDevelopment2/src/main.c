@@ -60,8 +60,8 @@ typedef struct{
 }led;
 
 
-uint16_t *LEDBuffer;
-led *LEDs;
+uint16_t LEDBuffer[TOTAL_CHANNELS];
+led LEDs[TOTAL_CHANNELS];
 led *activeLEDs[ACTIVE_LEDS];
 led *inactiveLEDs[TOTAL_CHANNELS-ACTIVE_LEDS];  
 
@@ -209,24 +209,6 @@ int main(){
 		sei();
 	}
 
-	LEDs = (led *)calloc(12*NUM_DRIVERS, sizeof(led));
-	LEDBuffer = (uint16_t *)calloc(TOTAL_CHANNELS, sizeof(uint16_t));
-//	LEDBuffer = (uint16_t *)calloc(2, TOTAL_CHANNELS*sizeof(uint16_t));
-//	LEDBuffer = (uint16_t *)calloc(2, TOTAL_CHANNELS);
-
-
-//	check for failed allocation
-	if (LEDs==NULL){
-		if(DEBUG_MODE > 0){
-			print("fl\n\r");
-		}
-	}
-
-	if (LEDBuffer==NULL){
-		if(DEBUG_MODE > 0){
-			print("fb\n\r");
-		}
-	}
 
 
 //	adc_init();
@@ -7,27 +7,82 @@ by an Atmega328p AVR microcontroller.
 The source is heavily based of the Adafruit_TLC59711
 libary, written by Limor Fried.  The original code
 has been stripped of all Arduino function calls and references.
-A bit-bang method of SPI transmission is utilized. 
+SPI transmission is bit-banged, done by the hardware SPI
+peripheral, or streamed through USART0 in master SPI mode,
+see SPI_BACKEND in TLC59711.h.
 
  */
 
 #include <stdint.h>
 #include <avr/io.h>
 #include <avr/interrupt.h>
-#include <util/delay.h>
 #include "TLC59711.h"
+#include "clock.h"
 
 
-void set_brightness(uint8_t channel, uint16_t brightness, uint16_t *pwmBuffer){
-	pwmBuffer[channel] = brightness;
-}
-
 void spi_init(void){
+
+	// latch deadlines are timed on the Timer0 time base
+	clock_init();
+
+#if SPI_BACKEND == SPI_BACKEND_HARDWARE
+	// MOSI, SCK and SS as outputs on portB (SS must be an output to stay master)
+	DDRB = (1 << DDB2) | (1 << DDB3) | (1 << DDB5);
+
+	// Enable SPI master, MSB first, mode 0, SCK = F_CPU/2
+	SPCR = (1 << SPE) | (1 << MSTR);
+	SPSR = (1 << SPI2X);
+#elif SPI_BACKEND == SPI_BACKEND_USART
+	// USART0 in master SPI mode, XCK0 (PD4) clock and TXD0 (PD1) data as outputs
+	UBRR0 = 0;
+	DDRD |= (1 << DDD4) | (1 << DDD1);
+
+	// MSPIM, MSB first, mode 0, transmitter only, SCK = F_CPU/2 (baud set after enable)
+	UCSR0C = (1 << UMSEL01) | (1 << UMSEL00);
+	UCSR0B = (1 << TXEN0);
+	UBRR0 = 0;
+#elif SPI_BACKEND == SPI_BACKEND_PARALLEL
+	// one data pin per chain from PB0 up, shared clock on PB5
+	DDRB = SPI_CHAIN_MASK | (1 << DDB5);
+#else
 	// SPI is bit-banged, set pins 4 and 5 as outputs on portB
 	DDRB = (1 << DDB4) | (1 << DDB5);
+#endif
+
+#ifdef SPI_PROFILE
+	// Timer2 free-running at F_CPU/128, only used to time the masked window
+	TCCR2A = 0;
+	TCCR2B = (1 << CS22) | (1 << CS20);
+#endif
 }
 
-void spi_write(uint16_t *pwmBuffer, uint8_t numDrivers, uint8_t blank){
+// Frame currently being pumped out by the transfer-complete ISR
+static uint8_t * volatile asyncFrame;
+static volatile uint16_t asyncRemaining;
+volatile uint8_t spiTransferComplete = 1;
+static volatile uint8_t latchPending = 0;
+static volatile uint16_t latchStamp;		// clock tick of the last SCK edge
+
+#ifdef SPI_PROFILE
+// Longest interrupts-masked window seen, in Timer2 ticks of SPI_PROFILE_TICK_CYCLES
+volatile uint8_t spiMaskedMax;
+
+#define PROFILE_MASK_BEGIN() {TCNT2 = 0;\
+							  TIFR2 = (1 << TOV2);\
+							 }
+
+// saturates at 0xFF (~2ms) if Timer2 overflowed
+#define PROFILE_MASK_END() {uint8_t ticks = (TIFR2 & (1 << TOV2)) ? 0xFF : TCNT2;\
+							if(ticks > spiMaskedMax) spiMaskedMax = ticks;\
+						   }
+#else
+#define PROFILE_MASK_BEGIN()
+#define PROFILE_MASK_END()
+#endif
+
+// Write the 32 bit TLC59711 command header into every driver's packet.
+// Only needs redoing when blank changes, PWM slots are left untouched.
+void spi_set_header(uint8_t *frame, uint8_t numDrivers, uint8_t blank){
 	uint32_t command;
 	command = 0x25;		// TLC59711 Magic Number
 
@@ -53,42 +108,296 @@ void spi_write(uint16_t *pwmBuffer, uint8_t numDrivers, uint8_t blank){
 	command <<= 7;
 	command |= BC_B;
 
+	for (uint8_t n = 0; n < numDrivers; n++, frame += SPI_BYTES_PER_DRIVER){
+		frame[0] = command >> 24;
+		frame[1] = command >> 16;
+		frame[2] = command >> 8;
+		frame[3] = command;
+	}
+}
+
+#if SPI_BACKEND == SPI_BACKEND_PARALLEL
+// Bit of chain k's byte into the port value. The mask is a constant, so it
+// compiles to a skip and an ori, 2 cycles. Chains past SPI_CHAINS drop out.
+#define PARALLEL_CHAIN(k, data, bit) if((SPI_CHAINS > (k)) && ((data) & (1 << (bit)))) out |= (1 << (k));
+
+// One clock with a bit of every chain: 2 cycles per chain, then the data
+// write and the clock edge, 4 cycles in all
+#define PARALLEL_BIT(bit) {uint8_t out = base;\
+						   PARALLEL_CHAIN(0, data0, bit)\
+						   PARALLEL_CHAIN(1, data1, bit)\
+						   PARALLEL_CHAIN(2, data2, bit)\
+						   PARALLEL_CHAIN(3, data3, bit)\
+						   PARALLEL_CHAIN(4, data4, bit)\
+						   PORTB = out;\
+						   PORTB = out | (1 << PB5);\
+						  }
+
+// Shift SPI_CHAINS slices of the frame at once. Chain k sends bytes
+// [k * length / SPI_CHAINS, (k + 1) * length / SPI_CHAINS). Each bit time the
+// chains' bits are gathered (bit-sliced) into one port value, so a single
+// write advances every chain and frame time only grows with drivers per chain.
+// Chains and bits are unrolled, nothing is indexed or shifted by a variable.
+static void shift_parallel(uint8_t *frame, uint16_t length){
+
+	uint16_t chainLength = length / SPI_CHAINS;
+
+	// one read pointer per chain, the ones past SPI_CHAINS are never used
+	uint8_t *chain0 = frame;
+	uint8_t *chain1 = frame + ((SPI_CHAINS > 1) ? chainLength : 0);
+	uint8_t *chain2 = frame + ((SPI_CHAINS > 2) ? 2 * chainLength : 0);
+	uint8_t *chain3 = frame + ((SPI_CHAINS > 3) ? 3 * chainLength : 0);
+	uint8_t *chain4 = frame + ((SPI_CHAINS > 4) ? 4 * chainLength : 0);
+
+	// port with clock and data pins low, other PORTB pins untouched
+	uint8_t base = PORTB & ~(SPI_CHAIN_MASK | (1 << PB5));
+
+	while(chainLength--){
+
+		uint8_t data0 = *chain0++;
+		uint8_t data1 = (SPI_CHAINS > 1) ? *chain1++ : 0;
+		uint8_t data2 = (SPI_CHAINS > 2) ? *chain2++ : 0;
+		uint8_t data3 = (SPI_CHAINS > 3) ? *chain3++ : 0;
+		uint8_t data4 = (SPI_CHAINS > 4) ? *chain4++ : 0;
+
+		// MSB first
+		PARALLEL_BIT(7);
+		PARALLEL_BIT(6);
+		PARALLEL_BIT(5);
+		PARALLEL_BIT(4);
+		PARALLEL_BIT(3);
+		PARALLEL_BIT(2);
+		PARALLEL_BIT(1);
+		PARALLEL_BIT(0);
+	}
+}
+#endif
+
+// Shift a frame out with interrupts masked. A pause of 8 SCK periods
+// anywhere in the frame is taken by the TLC59711 as a latch, so an ISR
+// firing mid-frame would latch a partial frame. Nothing else needs the mask.
+static void shift_frame(uint8_t *frame, uint16_t length){
+
+	uint8_t sreg = SREG;
 	cli();        		// Disable interrupts
+	PROFILE_MASK_BEGIN();
 
-	// Iterate over each driver
-	for (uint8_t n = 0; n < numDrivers; n++){
-		transfer(command >> 24);
-		transfer(command >> 16);
-		transfer(command >> 8);
-		transfer(command);
-
-		// Iterate over each channel of each driver, MSB first
-		for(int8_t c=11; c >= 0 ; c--){
-			transfer(pwmBuffer[c + (12 * n)]>>8);     
-			transfer(pwmBuffer[c + (12 * n)]);        
-		}
+#if SPI_BACKEND == SPI_BACKEND_USART
+	// Stream through the double-buffered UDR0, the next byte is queued while
+	// the current one shifts out so the clock never pauses mid-frame
+	UCSR0A |= (1 << TXC0);
+
+	while(length--){
+		USART_QUEUE(*frame++);
+	}
+
+	// wait for the last byte to leave the shift register
+	loop_until_bit_is_set(UCSR0A, TXC0);
+#elif SPI_BACKEND == SPI_BACKEND_HARDWARE
+	while(length--){
+		transfer(*frame++);
+	}
+#elif SPI_BACKEND == SPI_BACKEND_PARALLEL
+	shift_parallel(frame, length);
+#else
+	// Frames are whole drivers, always an even number of bytes
+	for(; length; length -= 2, frame += 2){
+		transfer16(((uint16_t)frame[0] << 8) | frame[1]);
+	}
+#endif
+
+	latchStamp = clock_ticks();
+
+	PROFILE_MASK_END();
+	SREG = sreg;	// Restore interrupts
+
+	latchPending = 1;
+}
+
+// Shift a wire-order frame out. Returns right after the last clock edge,
+// the latch interval is only waited out by the next transmission.
+void spi_write(uint8_t *frame, uint16_t length){
+
+	// let any previous frame finish and latch first
+	spi_wait();
+
+	shift_frame(frame, length);
+}
+
+// Start shifting a serialized frame out and return immediately. The frame
+// must stay untouched until spiTransferComplete is set; spi_wait() also
+// covers the latch interval before the next frame may start.
+void spi_write_async(uint8_t *frame, uint16_t length){
+
+	spi_wait();
+
+	if(!length){
+		return;
 	}
 
-	_delay_us(200);  //Allow for 218 LSBs to latch
+#if SPI_BACKEND == SPI_BACKEND_HARDWARE
+	asyncFrame = frame + 1;
+	asyncRemaining = length - 1;
+	spiTransferComplete = 0;
+
+	// A synchronous transfer() leaves SPIF set. Clear it (SPSR, then SPDR)
+	// or the ISR fires as soon as SPIE is set and the first byte collides.
+	(void)SPSR;
+	(void)SPDR;
+
+	// Slow SCK to F_CPU/SPI_ASYNC_SCK_DIV so ISR entry between bytes, even
+	// behind another ISR, stays below the TLC59711 latch detect of 8 SCK
+	// periods, see SPI_ISR_MAX_CYCLES
+	SPCR = (1 << SPE) | (1 << MSTR) | (1 << SPIE) | SPI_ASYNC_SPCR;
+	SPSR = SPI_ASYNC_SPSR;
+	SPDR = *frame;
+#elif SPI_BACKEND == SPI_BACKEND_USART
+	asyncFrame = frame;
+	asyncRemaining = length;
+	spiTransferComplete = 0;
 
-	sei();	//Enable interrupts
+	// Slow XCK to F_CPU/SPI_ASYNC_SCK_DIV for the same reason, the TX
+	// complete ISR refills the shift register and UDR0 two bytes at a time
+	UBRR0 = (SPI_ASYNC_SCK_DIV / 2) - 1;
+	UCSR0A |= (1 << TXC0);
+	USART_QUEUE(*asyncFrame++);
+	asyncRemaining--;
+	if(asyncRemaining){
+		USART_QUEUE(*asyncFrame++);
+		asyncRemaining--;
+	}
+	UCSR0B |= (1 << TXCIE0);
+#else
+	// No transfer interrupt when bit-banging, send it in place
+	shift_frame(frame, length);
+#endif
 }
 
+// Block until the last frame has shifted out and latched. Usually returns
+// at once, rendering takes longer than the latch interval.
+void spi_wait(void){
+
+	while(!spiTransferComplete);
+
+	if(latchPending){
+		while((uint16_t)(clock_ticks() - latchStamp) < SPI_LATCH_TICKS);
+		latchPending = 0;
+	}
+}
+
+#if SPI_BACKEND == SPI_BACKEND_HARDWARE
+ISR(SPI_STC_vect){
+
+	if(asyncRemaining){
+		SPDR = *asyncFrame++;
+		asyncRemaining--;
+	}
+
+	// frame done, back to the synchronous F_CPU/2 setup
+	else{
+		SPCR = (1 << SPE) | (1 << MSTR);
+		SPSR = (1 << SPI2X);
+		latchStamp = clock_ticks();
+		latchPending = 1;
+		spiTransferComplete = 1;
+	}
+}
+#elif SPI_BACKEND == SPI_BACKEND_USART
+ISR(USART_TX_vect){
+
+	if(asyncRemaining){
+		USART_QUEUE(*asyncFrame++);
+		asyncRemaining--;
+
+		if(asyncRemaining){
+			USART_QUEUE(*asyncFrame++);
+			asyncRemaining--;
+		}
+	}
+
+	// frame done, back to the synchronous F_CPU/2 setup
+	else{
+		UCSR0B &= ~(1 << TXCIE0);
+		UBRR0 = 0;
+		latchStamp = clock_ticks();
+		latchPending = 1;
+		spiTransferComplete = 1;
+	}
+}
+#endif
+
 // transfer is used by writeData to actually send data out of the micro-controller
 void transfer(uint32_t data){
 
-	// Bit Bang
-    uint32_t transferMask = 0x80;
-    for (; transferMask!=0; transferMask>>=1) {
-      CLOCK_LOW();
-      if (data & transferMask)  
-		DATA_HIGH();
-      else
-		DATA_LOW();
-    CLOCK_HIGH();
-  }
+#if SPI_BACKEND == SPI_BACKEND_HARDWARE
+	// Hardware SPI, wait for the byte to shift out
+	SPDR = (uint8_t)data;
+	while(!(SPSR & (1 << SPIF)));
+#elif SPI_BACKEND == SPI_BACKEND_USART
+	// USART master SPI, wait for the byte to shift out
+	UCSR0A |= (1 << TXC0);
+	UDR0 = (uint8_t)data;
+	loop_until_bit_is_set(UCSR0A, TXC0);
+#elif SPI_BACKEND == SPI_BACKEND_PARALLEL
+	// same byte on every chain
+	uint8_t base = PORTB & ~(SPI_CHAIN_MASK | (1 << PB5));
+	for(uint8_t mask = 0x80; mask; mask >>= 1){
+		uint8_t out = (data & mask) ? (base | SPI_CHAIN_MASK) : base;
+		PORTB = out;
+		PORTB = out | (1 << PB5);
+	}
+#else
+	transfer8(data);
+#endif
 
 }
 
 
 
+
+#if SPI_BACKEND == SPI_BACKEND_BITBANG
+// One unrolled bit: clock low, set data from the bit with a skip pair
+// (sbrc/sbi, sbrs/cbi) so either value costs the same, clock high.
+// 2 + 5 + 2 = 9 cycles per bit.
+#define BITBANG_BIT(data, bit) {CLOCK_LOW();\
+								if((data) & (1 << (bit))) DATA_HIGH();\
+								if(!((data) & (1 << (bit)))) DATA_LOW();\
+								CLOCK_HIGH();\
+							   }
+
+// Send one byte MSB first: 8 * 9 = 72 cycles plus ~8 cycles call/return
+void transfer8(uint8_t data){
+	BITBANG_BIT(data, 7);
+	BITBANG_BIT(data, 6);
+	BITBANG_BIT(data, 5);
+	BITBANG_BIT(data, 4);
+	BITBANG_BIT(data, 3);
+	BITBANG_BIT(data, 2);
+	BITBANG_BIT(data, 1);
+	BITBANG_BIT(data, 0);
+}
+
+// Send one 16 bit word MSB first: 16 * 9 = 144 cycles plus ~8 cycles call/return
+void transfer16(uint16_t data){
+	uint8_t high = data >> 8;
+	uint8_t low = data;
+
+	BITBANG_BIT(high, 7);
+	BITBANG_BIT(high, 6);
+	BITBANG_BIT(high, 5);
+	BITBANG_BIT(high, 4);
+	BITBANG_BIT(high, 3);
+	BITBANG_BIT(high, 2);
+	BITBANG_BIT(high, 1);
+	BITBANG_BIT(high, 0);
+
+	BITBANG_BIT(low, 7);
+	BITBANG_BIT(low, 6);
+	BITBANG_BIT(low, 5);
+	BITBANG_BIT(low, 4);
+	BITBANG_BIT(low, 3);
+	BITBANG_BIT(low, 2);
+	BITBANG_BIT(low, 1);
+	BITBANG_BIT(low, 0);
+}
+#endif
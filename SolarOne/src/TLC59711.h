@@ -1,24 +1,148 @@
 #ifndef _TLC59711_H
 #define _TLC59711_H
 
-// SPI Macros
+// Transport backends, selected at compile time (e.g. -DSPI_BACKEND=SPI_BACKEND_HARDWARE)
+#define SPI_BACKEND_BITBANG 0       // CLOCK/DATA macros below, any port pins
+#define SPI_BACKEND_HARDWARE 1      // ATmega328P SPI peripheral at F_CPU/2, data on MOSI
+#define SPI_BACKEND_USART 2         // USART0 master SPI at F_CPU/2, data on TXD0, clock on XCK0
+#define SPI_BACKEND_PARALLEL 3      // SPI_CHAINS bit-banged chains, data on PB0.., shared clock on PB5
+
+#ifndef SPI_BACKEND
+#define SPI_BACKEND SPI_BACKEND_BITBANG
+#endif
+
+// SPI Macros (bit-bang backend; the hardware backend uses MOSI/PB3 and SCK/PB5)
 #define CLOCK_HIGH() (PORTB |= (1<<PB5))   // Devboard pin 13   
 #define CLOCK_LOW() (PORTB &= (~(1<<PB5)))
 #define DATA_HIGH() (PORTB |= (1<<PB4))    // Devboard pin 12 
 #define DATA_LOW() (PORTB &= (~(1<<PB4)))
 
+// Parallel chains: chain k takes its data on PB<k> and an equal share of the drivers
+#ifndef SPI_CHAINS
+#define SPI_CHAINS 2
+#endif
+#define SPI_CHAIN_MASK ((1 << SPI_CHAINS) - 1)
+
+#if (SPI_BACKEND == SPI_BACKEND_PARALLEL) && ((SPI_CHAINS < 1) || (SPI_CHAINS > 5))
+#error "SPI_CHAINS data pins must fit on PB0..PB4"
+#endif
+
+// USART master SPI: queue a byte behind the one currently shifting out
+#define USART_QUEUE(b) {loop_until_bit_is_set(UCSR0A, UDRE0);\
+						UDR0 = (uint8_t)(b);\
+					   }
+
 // RGB brightness levels. Not using for RGB LEDs, set to full brightness
 #define BC_R 0x7F     
 #define BC_G 0x7F
 #define BC_B 0x7F
 
 // Fucntion Prototypes
-void set_brightness(uint8_t channel, uint16_t brightness, uint16_t *pwmBuffer);
 void spi_init(void);
 // void spi_write(uint16_t *pwmBuffer, uint8_t numDrivers);
-void spi_write(uint16_t *pwmBuffer, uint8_t numDrivers, uint8_t blank);
+void spi_write(uint8_t *frame, uint16_t length);
 void transfer(uint32_t data); 
+#if SPI_BACKEND == SPI_BACKEND_BITBANG
+void transfer8(uint8_t data);
+void transfer16(uint16_t data);
+#endif
+void spi_set_header(uint8_t *frame, uint8_t numDrivers, uint8_t blank);
+void spi_write_async(uint8_t *frame, uint16_t length);
+void spi_wait(void);
+
+// Set once an asynchronous frame has shifted out (latch interval still pending)
+extern volatile uint8_t spiTransferComplete;
+
+// Build with -DSPI_PROFILE to record the longest interrupts-masked window,
+// i.e. the worst ISR latency the transport adds, in units of 128 cycles (8us).
+// Windows of 2ms or more read 0xFF.
+#ifdef SPI_PROFILE
+#define SPI_PROFILE_TICK_CYCLES 128
+#define SPI_PROFILE_TICK_US (SPI_PROFILE_TICK_CYCLES / (F_CPU / 1000000))
+extern volatile uint8_t spiMaskedMax;
+#endif
 
 // Constants
+#define SPI_BYTES_PER_DRIVER 28     // 4 header bytes + 12 channels * 16 bits
+#define SPI_FRAME_BYTES(n) (SPI_BYTES_PER_DRIVER * (n))
+
+// Frames are kept in wire order: per driver the 4 header bytes, then channels
+// 11..0 as big-endian words. Byte offset of a channel's PWM word:
+#define SPI_SLOT(ch) ((SPI_BYTES_PER_DRIVER * ((ch) / 12)) + 4 + (2 * (11 - ((ch) % 12))))
+#define SPI_LATCH_US 200            // SCK idle time for the TLC59711 to latch, from the last edge
+#define SPI_LATCH_TICKS US_TO_TICKS(SPI_LATCH_US)
+#ifndef SPI_ASYNC_SCK_DIV
+#define SPI_ASYNC_SCK_DIV 32        // SCK divider for interrupt-driven frames, 2us per bit at 16MHz
+#endif
+
+// SPCR rate bits and SPSR for the hardware backend at SPI_ASYNC_SCK_DIV
+#if SPI_ASYNC_SCK_DIV == 2
+#define SPI_ASYNC_SPCR 0
+#define SPI_ASYNC_SPSR (1 << SPI2X)
+#elif SPI_ASYNC_SCK_DIV == 4
+#define SPI_ASYNC_SPCR 0
+#define SPI_ASYNC_SPSR 0
+#elif SPI_ASYNC_SCK_DIV == 8
+#define SPI_ASYNC_SPCR (1 << SPR0)
+#define SPI_ASYNC_SPSR (1 << SPI2X)
+#elif SPI_ASYNC_SCK_DIV == 16
+#define SPI_ASYNC_SPCR (1 << SPR0)
+#define SPI_ASYNC_SPSR 0
+#elif SPI_ASYNC_SCK_DIV == 32
+#define SPI_ASYNC_SPCR (1 << SPR1)
+#define SPI_ASYNC_SPSR (1 << SPI2X)
+#elif SPI_ASYNC_SCK_DIV == 64
+#define SPI_ASYNC_SPCR (1 << SPR1)
+#define SPI_ASYNC_SPSR 0
+#elif SPI_ASYNC_SCK_DIV == 128
+#define SPI_ASYNC_SPCR ((1 << SPR1) | (1 << SPR0))
+#define SPI_ASYNC_SPSR 0
+#else
+#error "SPI_ASYNC_SCK_DIV must be a power of two from 2 to 128"
+#endif
+
+// An asynchronous frame is pumped a byte (USART: two) per ISR. A pause of 8 SCK
+// periods latches, so the next byte must be queued within 7 of them, 224 cycles
+// at SPI_ASYNC_SCK_DIV 32. Any other ISR that is running holds the pump off, so
+// every other ISR (Timer0 clock, Timer1 countdown, debug UART) has to stay under
+// SPI_ISR_MAX_CYCLES. ADC reads and debug prints belong in the main loop.
+#define SPI_PUMP_ISR_CYCLES 40      // entry, refill and exit of the pump ISR
+#define SPI_ISR_MAX_CYCLES 120      // longest any other ISR may run
+
+#if (SPI_PUMP_ISR_CYCLES + SPI_ISR_MAX_CYCLES) >= (7 * SPI_ASYNC_SCK_DIV)
+#error "SPI_ASYNC_SCK_DIV leaves other ISRs no time before the TLC59711 latches"
+#endif
+
+// Approximate cost of one transfer() call, from instruction timing at -Os.
+// Bit-bang: unrolled, 9 cycles per bit, frames sent a word at a time with transfer16().
+// Hardware: 16 cycles on the wire at F_CPU/2, plus SPDR load, SPIF poll and call overhead.
+// USART: 16 cycles on the wire at F_CPU/2, bytes are queued back to back with no gap.
+#if SPI_BACKEND == SPI_BACKEND_HARDWARE
+#define SPI_CYCLES_PER_BYTE 30
+#elif SPI_BACKEND == SPI_BACKEND_USART
+#define SPI_CYCLES_PER_BYTE 16
+#elif SPI_BACKEND == SPI_BACKEND_PARALLEL
+// per byte slot (one byte on every chain), estimated from the unrolled shift_parallel,
+// not measured: 8 * (2 per chain + 4) + ~3 per chain to load + ~4 loop
+#define SPI_CYCLES_PER_BYTE (((8 * ((2 * SPI_CHAINS) + 4)) + (3 * SPI_CHAINS) + 4) / SPI_CHAINS)
+#else
+#define SPI_CYCLES_PER_BYTE 80
+#endif
+
+// Cycles spent shifting one frame out to a chain of n drivers, latch wait excluded.
+// NUM_DRIVERS = 2 -> bit-bang ~4500 cycles (~280us), hardware ~1700 cycles (~105us),
+// USART ~900 cycles (~56us) at 16MHz. Parallel divides the frame between SPI_CHAINS chains:
+// 8 drivers on 4 chains ~6300 cycles (~390us), bit-bang would take ~17900 cycles.
+// spi_write() returns after the last edge, the next one waits out whatever is left of
+// SPI_LATCH_US (nothing, when a frame was rendered in between).
+#define SPI_FRAME_CYCLES(n) ((uint32_t)(n) * SPI_BYTES_PER_DRIVER * SPI_CYCLES_PER_BYTE)
+
+// Interrupts are masked only while the frame shifts (SPI_FRAME_CYCLES). Worst-case added
+// ISR latency, NUM_DRIVERS = 2 at 16MHz: bit-bang ~280us, hardware ~105us, USART ~56us, asynchronous none (was frame + 200us latch, ~1.06ms
+// with the original bit-bang transfer).
+//
+// spi_write_async() shifts at F_CPU/SPI_ASYNC_SCK_DIV (~16us per byte, ~900us for
+// NUM_DRIVERS = 2) in the background. CPU cost is one ~40 cycle ISR per byte on the
+// hardware backend, per two bytes on the USART backend. Bit-bang and parallel send in place.
 
 #endif
@@ -0,0 +1,87 @@
+/* clock.c
+
+Free-running time base on Timer0. The counter
+runs at F_CPU/256 and the overflow interrupt
+extends it to 16 bits, which wraps every ~1.05s
+at 16MHz. Compare timestamps by subtraction.
+
+The same interrupt keeps a millisecond count for
+slower timing, which wraps every ~65s. An overflow
+every ~4ms leaves room for long masked frames.
+
+ */
+
+#include <stdint.h>
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include "clock.h"
+
+// high byte of the tick count
+static volatile uint8_t clockOverflows;
+
+// milliseconds, and the 8us units left over
+static volatile uint16_t clockMillis;
+static volatile uint8_t clockFract;
+
+
+// Start Timer0, safe to call again, the count is not reset
+void clock_init(void){
+
+	// normal mode, prescaler 256, interrupt on overflow
+	TCCR0A = 0;
+	TCCR0B = (1 << CS02);
+	TIMSK0 |= (1 << TOIE0);
+}
+
+// Current tick count, callable with interrupts enabled or from an ISR
+uint16_t clock_ticks(void){
+
+	uint8_t sreg = SREG;
+	cli();
+
+	uint8_t high = clockOverflows;
+	uint8_t low = TCNT0;
+
+	// overflow happened but has not been serviced yet
+	if((TIFR0 & (1 << TOV0)) && (low < 255)){
+		high++;
+	}
+
+	SREG = sreg;
+
+	return ((uint16_t)high << 8) | low;
+}
+
+// Milliseconds since the clock started, callable with interrupts enabled or from an ISR
+uint16_t clock_ms(void){
+
+	uint8_t sreg = SREG;
+	cli();
+
+	uint16_t ms = clockMillis;
+	uint16_t us = clockFract << 3;
+	uint8_t low = TCNT0;
+
+	// overflow happened but has not been serviced yet
+	if((TIFR0 & (1 << TOV0)) && (low < 255)){
+		us += CLOCK_OVERFLOW_US;
+	}
+
+	SREG = sreg;
+
+	// add the time since the last overflow, so the count moves every ms
+	us += low * CLOCK_TICK_US;
+
+	return ms + (us / 1000);
+}
+
+ISR(TIMER0_OVF_vect){
+	clockOverflows++;
+
+	clockMillis += CLOCK_MS_INC;
+	clockFract += CLOCK_FRACT_INC;
+	if(clockFract >= CLOCK_FRACT_MAX){
+		clockFract -= CLOCK_FRACT_MAX;
+		clockMillis++;
+	}
+}
@@ -0,0 +1,35 @@
+#ifndef CLOCK_H
+#define CLOCK_H
+
+/*
+ * clock.h
+ *
+ * Free-running time base on Timer0.
+ *
+ */
+
+#ifndef F_CPU
+#define F_CPU 16000000
+#endif
+
+// Timer0 runs at F_CPU/256, one tick every 16us at 16MHz
+#define CLOCK_PRESCALE 256
+#define CLOCK_TICK_US (CLOCK_PRESCALE / (F_CPU / 1000000))
+
+// Ticks guaranteed to cover at least us microseconds (one extra for tick granularity)
+#define US_TO_TICKS(us) ((((us) + CLOCK_TICK_US - 1) / CLOCK_TICK_US) + 1)
+
+// Milliseconds are counted on the overflow interrupt, every 256 ticks (4.096ms
+// at 16MHz). The part past a whole millisecond is carried in units of 8us,
+// clock_ms() adds the ticks since the last overflow.
+#define CLOCK_OVERFLOW_US (256 * CLOCK_TICK_US)
+#define CLOCK_MS_INC (CLOCK_OVERFLOW_US / 1000)
+#define CLOCK_FRACT_INC ((CLOCK_OVERFLOW_US % 1000) >> 3)
+#define CLOCK_FRACT_MAX (1000 >> 3)
+
+// Function Prototypes
+void clock_init(void);
+uint16_t clock_ticks(void);
+uint16_t clock_ms(void);
+
+#endif // CLOCK_H
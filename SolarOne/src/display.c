@@ -7,22 +7,108 @@
 
  */
 
-// brightness tables
-
 #include "display.h"
 
+// Display state, see display.h
+uint8_t *frontFrame;
+uint8_t *backFrame;
+uint16_t ledStart[TOTAL_CHANNELS];
+uint8_t ledHold[TOTAL_CHANNELS];
+uint8_t ledFadeIn[TOTAL_CHANNELS];
+uint8_t ledFadeOut[TOTAL_CHANNELS];
+uint16_t ledDeadline[TOTAL_CHANNELS];
+channel_t ledNext[TOTAL_CHANNELS];
+channel_t wheelHead[DISPLAY_WHEEL_SLOTS];
+channel_t fadeInLEDs[ACTIVE_LEDS];
+channel_t fadeInCount;
+channel_t fadeOutLEDs[ACTIVE_LEDS];
+channel_t fadeOutCount;
+channel_t activeCount;
+channel_t endedLEDs[ACTIVE_LEDS];
+channel_t endedCount;
+uint16_t displayTick;
+uint8_t ledPool[POOL_BYTES];
+
+// Drivers whose packet in backFrame differs from frontFrame, one bit each
+static uint8_t dirtyDrivers[(NUM_DRIVERS + 7) / 8];
+static uint8_t frameDirty;
+
+// Storage behind frontFrame and backFrame
+static uint8_t frameBuffers[2][FRAME_BYTES];
+
+// Clear bits in each nibble value, for pool_select
+const uint8_t nibbleFree[16] PROGMEM = {4, 3, 3, 2, 3, 2, 2, 1, 3, 2, 2, 1, 2, 1, 1, 0};
+
+channel_t activeTarget = ACTIVE_LEDS;
+
+// clock_ms() at the last frame, and how far past displayTick it was in 1/65536 steps
+static uint16_t displayClock;
+static uint16_t displayFrac;
+
+// frac of the frame being rendered, for leds placed mid-frame
+static uint8_t renderFrac;
+
+// replacements the frame being rendered may still make, see end_led
+static uint8_t frameBudget;
+
+// Parameters for the next replacements, paramCount of them from paramHead
+static led_params paramRing[DISPLAY_PARAM_RING];
+static uint8_t paramHead;
+static uint8_t paramCount;
+
+#ifdef DISPLAY_PROFILE
+uint32_t displayProfileTicks[ACTIVE_LEDS + 1];
+uint32_t displayProfileFrames[ACTIVE_LEDS + 1];
+uint16_t displayProfileHist[DISPLAY_PROFILE_BINS];
+#endif
+
+uint32_t framesSent;
+uint32_t framesSkipped;
+
 
 void write_display(void){
 
-		update_display();
-		spi_write(LEDBuffer, NUM_DRIVERS,0);
+		// advance the timeline by the time since the last frame
+		uint16_t ms = clock_ms();
+		uint32_t phase = (uint32_t)(uint16_t)(ms - displayClock) * DISPLAY_STEP_RATE + displayFrac;
+
+		displayClock = ms;
+		displayFrac = phase;
+
+		// render the next frame while the previous one is still shifting out
+#ifdef DISPLAY_PROFILE
+		uint16_t begin = clock_ticks();
+		update_display(displayTick + (uint16_t)(phase >> 16), displayFrac >> 8);
+		uint16_t ticks = clock_ticks() - begin;
+		channel_t fading = fadeInCount + fadeOutCount;
+		displayProfileTicks[fading] += ticks;
+		displayProfileFrames[fading]++;
+		profile_frame(ticks);
+#else
+		update_display(displayTick + (uint16_t)(phase >> 16), displayFrac >> 8);
+#endif
+
+		// nothing changed, the drivers keep displaying the last frame (DSPRPT)
+		if(!frameDirty){
+			framesSkipped++;
+			return;
+		}
+
+		// frame buffer is free once the previous frame has shifted out and latched
+		spi_wait();
+
+		// publish the completed frame and hand it to the transport
+		swap_frames();
+		spi_write_async(frontFrame, FRAME_BYTES);
+		framesSent++;
 		// _delay_ms(UPDATE_DELAY);
 }
 
 void setup_display(void){
 
-	LEDs = (led *)calloc(12*NUM_DRIVERS, sizeof(led));
-	LEDBuffer = (uint16_t *)calloc(TOTAL_CHANNELS, sizeof(uint16_t));
+	// frames alternate between the two buffers, see swap_frames
+	frontFrame = frameBuffers[0];
+	backFrame = frameBuffers[1];
 
 }
 
@@ -34,248 +120,565 @@ void display_init(void){
 	spi_init();
 	// display_init();
 
-	// Create array to hold randomly selected starting points
-	int8_t randSelect[ACTIVE_LEDS];
-	// initialize random array each element to a value above TOTAL_CHANNELS
-	for(uint8_t i=0; i<ACTIVE_LEDS; i++ ){randSelect[i]=TOTAL_CHANNELS;}
-
 	// initialize all leds
-	for(uint8_t i=0; i<TOTAL_CHANNELS; i++ ){
-		LEDs[i] = make_led(i);
+	for(channel_t i=0; i<TOTAL_CHANNELS; i++ ){
+		make_led(i);
 	}
 
+	// empty the pool, the bits past the last channel are never free
+	memset(ledPool, 0, sizeof(ledPool));
+#if TOTAL_CHANNELS & 7
+	ledPool[POOL_BYTES - 1] = (uint8_t)(0xFF << (TOTAL_CHANNELS & 7));
+#endif
+	activeCount = 0;
+
+	// empty the timeline
+	memset(wheelHead, 0xFF, sizeof(wheelHead));
+	fadeInCount = 0;
+	fadeOutCount = 0;
+	displayTick = 0;
+	displayFrac = 0;
+	displayClock = clock_ms();
+
+	// pick the starting set with Floyd's sampling, one draw per led: a draw
+	// that lands on a channel already taken takes the newest candidate instead
+	for(channel_t j=TOTAL_CHANNELS-activeTarget; j<TOTAL_CHANNELS; j++){
+
+		channel_t pick = PRNG(0, j+1);
+
+		if(POOL_TAKEN(pick)){
+			pick = j;
+		}
 
-	// Generate unique set of leds to initiate
-	for(uint8_t i = 0; i <ACTIVE_LEDS; i++){
+		POOL_TAKE(pick);
+		activeCount++;
+		start_led(pick, displayTick);
+	}
 
-		uint8_t select = 0;
-		uint8_t new = 0;
+	// draw the first replacements before the show starts
+	paramHead = 0;
+	paramCount = 0;
+	fill_params(DISPLAY_PARAM_RING);
+	endedCount = 0;
 
-		// check that random number has not already been selected
-		do{
-			select = 0;
-			new = PRNG(0, TOTAL_CHANNELS);
+	// blank the outputs, then leave the headers enabled for write_display
+	spi_set_header(frontFrame, NUM_DRIVERS, 1);
+	spi_write(frontFrame, FRAME_BYTES);
+	spi_set_header(frontFrame, NUM_DRIVERS, 0);
+	spi_set_header(backFrame, NUM_DRIVERS, 0);
 
-			for(uint8_t j=0; j<ACTIVE_LEDS; j++ ){
 
-				// not unique number, generate new
-				if (new == randSelect[j]){
-					select = 1;
-					break;
-				}
-			}
+}
+
+
+// Swap front and back at a frame boundary. Only channels that changed are
+// rendered, so the new back frame is brought up to date from the new front,
+// copying just the packets of drivers that changed.
+void swap_frames(void){
+
+	uint8_t *tmpFrame = frontFrame;
+	frontFrame = backFrame;
+	backFrame = tmpFrame;
+
+	for(uint8_t n = 0; n < NUM_DRIVERS; n++){
+		if(dirtyDrivers[n >> 3] & (1 << (n & 7))){
+			memcpy(&backFrame[SPI_BYTES_PER_DRIVER * n], &frontFrame[SPI_BYTES_PER_DRIVER * n], SPI_BYTES_PER_DRIVER);
+		}
+	}
+
+	memset(dirtyDrivers, 0, sizeof(dirtyDrivers));
+	frameDirty = 0;
+
+}
+
+
+// Write a channel into the back frame, marking its driver dirty on change
+void render_channel(channel_t channel, uint16_t brightness){
+
+	uint8_t *slot = &backFrame[SPI_SLOT(channel)];
+
+	if((slot[0] == (uint8_t)(brightness >> 8)) && (slot[1] == (uint8_t)brightness)){
+		return;
+	}
+
+	slot[0] = brightness >> 8;
+	slot[1] = brightness;
+
+	uint8_t n = channel / 12;
+	dirtyDrivers[n >> 3] |= (1 << (n & 7));
+	frameDirty = 1;
+
+}
+
+
+// Retire a led that has faded out, starting a random inactive channel in
+// its place from tick, or just dropping it if there are more active leds
+// than wanted
+void replace_led(channel_t deadLED, uint16_t tick){
+
+	if(activeCount > activeTarget){
+		activeCount--;
+	}
+
+	else{
+		channel_t freshLED = pool_select(PRNG(0, TOTAL_CHANNELS-activeCount));
+		POOL_TAKE(freshLED);
+		start_led(freshLED, tick);
+	}
+
+	// refresh recently active led's parameters
+	POOL_FREE(deadLED);
+	refresh_led(deadLED);
+
+}
+
+
+// Start a random inactive channel
+void activate_led(void){
 
-		}while(select);
+	channel_t freshLED = pool_select(PRNG(0, TOTAL_CHANNELS-activeCount));
+	POOL_TAKE(freshLED);
+	activeCount++;
+	start_led(freshLED, displayTick);
+
+}
+
+
+// Put a freshly taken channel on the timeline, counting the start delay in
+// ledStart from tick. A start that is already due joins the fade ins, which
+// are stepped last in update_display and move it on if it is further along.
+void start_led(channel_t channel, uint16_t tick){
+
+	ledStart[channel] += tick;
+
+	if((int16_t)(ledStart[channel] - displayTick) <= 0){
+		fadeInLEDs[fadeInCount++] = channel;
+	}
+
+	else{
+		wait_led(channel, ledStart[channel]);
+	}
+
+}
+
+
+// File a started led under its stage at the tick being rendered, and render
+// it there. Leds come here when a wait ends or a fade runs out, which after a
+// long gap can be several stages on.
+void place_led(channel_t channel){
+
+	uint16_t brightness;
+
+	switch(led_state(channel, displayTick, renderFrac, &brightness)){
+
+		case startDelay :
+			wait_led(channel, ledStart[channel]);
+			break;
+
+		case fadeIn :
+			fadeInLEDs[fadeInCount++] = channel;
+			break;
+
+		case hold :
+			wait_led(channel, ledStart[channel] + FADE_STEPS(ledFadeIn[channel]) + ledHold[channel]);
+			break;
+
+		case fadeOut :
+			ledDeadline[channel] = ledStart[channel] + FADE_STEPS(ledFadeIn[channel]) + ledHold[channel];
+			fadeOutLEDs[fadeOutCount++] = channel;
+			break;
+
+		default :
+			end_led(channel);
+			return;
 
-		// record the random integer
-		randSelect[i] = new;
 	}
 
+	render_channel(channel, brightness);
 
-	// Mark inactive leds
-	uint8_t i; // total count
-	uint8_t j; // active count
-	uint8_t k; // inactive count
-	for(i=0, j=0, k=0; i<TOTAL_CHANNELS; i++ ){
+}
+
+
+// Park a led in the timer wheel until the deadline tick
+void wait_led(channel_t channel, uint16_t deadline){
+
+	channel_t *head = &wheelHead[deadline & WHEEL_MASK];
+
+	ledDeadline[channel] = deadline;
+	ledNext[channel] = *head;
+	*head = channel;
+
+}
+
+
+// Change how many leds are lit. Extra leds are dropped as they terminate,
+// missing ones are started one per frame.
+void set_active_leds(channel_t count){
+
+	activeTarget = (count > ACTIVE_LEDS) ? ACTIVE_LEDS : count;
 
-		uint8_t select = 0;
+}
+
+
+// Channel of the rank-th clear bit in ledPool, rank < TOTAL_CHANNELS - activeCount
+channel_t pool_select(channel_t rank){
+
+	channel_t n = 0;
+	uint8_t bits = ledPool[0];
+	uint8_t free;
+
+	// skip whole bytes with too few free channels
+	while(rank >= (free = POOL_FREE_BITS(bits))){
+		rank -= free;
+		bits = ledPool[++n];
+	}
 
-		// check if led is active (in randArray)
-		for(uint16_t l=0; l<ACTIVE_LEDS; l++){
-			if(i == randSelect[l]){
-				select = 1;
-				break;
+	// then walk the free bits of the byte that holds it
+	n <<= 3;
+	for(;;){
+		if(!(bits & 1)){
+			if(!rank){
+				return n;
 			}
+			rank--;
 		}
+		bits >>= 1;
+		n++;
+	}
 
-		if(select){
-			activeLEDs[j] = &LEDs[i];
-			j++;
-		}
-		else{
-			inactiveLEDs[k] = &LEDs[i];
-			k++;
-		}
+}
 
+
+void make_led(channel_t index){
+
+	led_params params;
+
+	draw_params(&params);
+	load_params(index, &params);
+
+}
+
+
+
+void refresh_led(channel_t deadLED){
+
+	led_params params;
+
+	// take the next parameters drawn in idle time, draw them here only if
+	// display_idle has not kept up
+	if(paramCount){
+		params = paramRing[paramHead];
+		paramHead = (paramHead + 1) & PARAM_RING_MASK;
+		paramCount--;
 	}
 
-	spi_write(LEDBuffer, NUM_DRIVERS, 1);
+	else{
+		draw_params(&params);
+	}
 
+	load_params(deadLED, &params);
+	render_channel(deadLED, 0x0000);
 
 }
 
 
-void replace_led(led **deadLED, led **freshLED){
+// Draw random parameters for a led's next lifecycle
+void draw_params(led_params *params){
 
-	led *tmpLED = *deadLED;
-	*deadLED = *freshLED;
-	*freshLED = tmpLED;
+	params->fadeIn = PRNG(0,NUM_FADES);
+	params->fadeOut = PRNG(0,NUM_FADES);
 
-	// refresh recently active led's parameters
-	refresh_led(*freshLED);
+	params->delay = PRNG(60, 180);
+	params->hold = PRNG(60,120);
 
 }
 
-led make_led(uint8_t index){
 
-	uint8_t fadeInSelect = PRNG(0,2);
-	uint8_t fadeOutSelect = PRNG(0,2);
+// Give an inactive channel its next lifecycle
+void load_params(channel_t channel, const led_params *params){
 
-//	uint8_t fadeInSelect = 2;
-//	uint8_t fadeOutSelect = 2;
+	ledStart[channel] = params->delay;		// start delay
+	ledHold[channel] = params->hold;
+	ledFadeIn[channel] = params->fadeIn;
+	ledFadeOut[channel] = params->fadeOut;
 
+}
 
-	// MOD Changing brightness to be 0x0000 by default
-	// .fadeInTableSize= 60 + (fadeInSelect*30),
-	// .fadeOutTableSize= 60 + (fadeOutSelect*30),
-	// .brightness= &(LEDBuffer[index]),
-	// Tried, may hav cause bug -->
 
-	led new = {
-					.startDelayTime= PRNG(60, 180),
-					.holdTime= PRNG(60,120),
-					.fadeInTable= (uint16_t *) fade[fadeInSelect],
-					.fadeOutTable= (uint16_t *) fade[fadeOutSelect],
-					.fadeInTableSize= tableSizes[fadeInSelect],
-					.fadeOutTableSize= tableSizes[fadeOutSelect],
-					.fadeLevel= 0,
-					.brightness= &(LEDBuffer[index]),
-					.stage= ready
-				};
+// Top up the parameter ring, call whenever there is time to spare between
+// frames so replacements in update_display never have to draw. At most
+// DISPLAY_REFILL_BUDGET sets are drawn per call.
+void display_idle(void){
 
-	return new;
+	fill_params(DISPLAY_REFILL_BUDGET);
 
 }
 
 
+// Draw up to count parameter sets into the ring
+void fill_params(uint8_t count){
+
+	while(count-- && (paramCount < DISPLAY_PARAM_RING)){
+		draw_params(&paramRing[(paramHead + paramCount) & PARAM_RING_MASK]);
+		paramCount++;
+	}
 
-void refresh_led(led *deadLED){
+}
 
-	// TODO: upper limit is dependent on number of fade tables
-	uint8_t fadeInSelect = PRNG(0,2);
-	uint8_t fadeOutSelect = (PRNG(0,2));
 
+// Replace a terminated led with a randomly selected inactive led, starting
+// from the tick the fade out ended, while the frame has budget left.
+// Otherwise leave it dark until a later frame.
+void end_led(channel_t channel){
 
-	// MOD changing default brightness to be 0x0000
-	//	(*deadLED).fadeInTableSize = 60 + (fadeInSelect*30);
-	//	(*deadLED).fadeOutTableSize = 60 + (fadeOutSelect*30);
-	//  *((*deadLED).brightness) = (*deadLED).fadeInTable[0];		// set brightness to 0x0000 upon init
+	if(frameBudget){
+		frameBudget--;
+		replace_led(channel, ledStart[channel] + FADE_STEPS(ledFadeIn[channel]) + ledHold[channel] + FADE_STEPS(ledFadeOut[channel]));
+	}
 
-	// Generate and assign random parameters
-	(*deadLED).startDelayTime = PRNG(60,180);
-	(*deadLED).holdTime = PRNG(60,120);
-	(*deadLED).fadeInTable = (uint16_t *) fade[fadeInSelect];
-	(*deadLED).fadeOutTable = (uint16_t *) fade[fadeOutSelect];
-	(*deadLED).fadeInTableSize= tableSizes[fadeInSelect];
-	(*deadLED).fadeOutTableSize= tableSizes[fadeOutSelect];
-	(*deadLED).fadeLevel = 0;
-	*((*deadLED).brightness) = 0x0000;
-	(*deadLED).stage = ready;
+	else{
+		render_channel(channel, 0x0000);
+		endedLEDs[endedCount++] = channel;
+	}
 
 }
 
 
-void update_display(void){
+// Stage of a started led frac/256 of the way from tick now to the next,
+// with its brightness. Nothing but the tick moves a led along, so frames
+// can be skipped or repeated freely as long as a started led is looked at
+// at least every 32767 ticks.
+uint8_t led_state(channel_t channel, uint16_t now, uint8_t frac, uint16_t *brightness){
+
+	int16_t t = now - ledStart[channel];
+	uint8_t steps;
+
+	*brightness = 0x0000;
 
-	// loop through all active leds
-	for(uint8_t i=0; i<ACTIVE_LEDS; i++){
+	if(t < 0){
+		return startDelay;
+	}
+
+	steps = FADE_STEPS(ledFadeIn[channel]);
+	if(t < steps){
+		*brightness = fade_level(ledFadeIn[channel], t, frac);
+		return fadeIn;
+	}
+
+	t -= steps;
+	if(t < ledHold[channel]){
+		*brightness = FADE_MAX;
+		return hold;
+	}
+
+	// fade out runs the curve backwards, from the peak down to 0
+	t -= ledHold[channel];
+	steps = FADE_STEPS(ledFadeOut[channel]);
+	if(t < steps){
+		*brightness = fade_level(ledFadeOut[channel], steps - 1 - t, 256 - frac);
+		return fadeOut;
+	}
+
+	return terminated;
+
+}
 
-		// jump to state
-		switch((*activeLEDs[i]).stage){
 
-			case ready :
-				(*activeLEDs[i]).stage = startDelay;
-				break;
+// Level of a curve after step steps plus weight/256 of the next, step <
+// FADE_STEPS(curve): the last stored mark plus the deltas since. Frames
+// between two steps interpolate with the weight.
+uint16_t fade_level(uint8_t curve, uint8_t step, uint16_t weight){
 
-			case startDelay :
+	uint16_t level = FADE_MARK(curve, step);
 
-				// if delay has elapsed, go to next stage
-				if(!((*activeLEDs[i]).startDelayTime)){
-					(*activeLEDs[i]).stage = fadeIn;
-				}
+	for(uint8_t i = step & ~(FADE_MARK_STEPS - 1); i < step; i++){
+		level += FADE_DELTA(curve, i);
+	}
+
+	return level + (uint16_t)(((uint32_t)FADE_DELTA(curve, step) * weight) >> 8);
 
-				else{
-					((*activeLEDs[i]).startDelayTime)--;
-				}
+}
 
-				break;
 
-			case fadeIn :
+void update_display(uint16_t now, uint8_t frac){
 
-				// if max brightness has been reached go to next stage
-				if((*activeLEDs[i]).fadeLevel >= (*activeLEDs[i]).fadeInTableSize){
-					(*activeLEDs[i]).stage = hold;
-				}
+	uint16_t ticks = now - displayTick;
 
-				else{
-					*((*activeLEDs[i]).brightness) = (*activeLEDs[i]).fadeInTable[(*activeLEDs[i]).fadeLevel];
-					((*activeLEDs[i]).fadeLevel)++;
-				}
+	displayTick = now;
+	renderFrac = frac;
+
+	// DISPLAY_FRAME_BUDGET per tick since the last frame, so replacements
+	// keep up with the leds ending however the frames are spaced, capped
+	// at DISPLAY_FRAME_BUDGET_MAX, which a backlog gets straight away
+	if(endedCount || (ticks > DISPLAY_FRAME_BUDGET_MAX / DISPLAY_FRAME_BUDGET)){
+		frameBudget = DISPLAY_FRAME_BUDGET_MAX;
+	}
 
-				break;
+	else{
+		frameBudget = (ticks ? ticks : 1) * DISPLAY_FRAME_BUDGET;
+	}
 
-			case hold :
+	// replacements put off by earlier frames go first, oldest first. They
+	// start now, from their old end tick a long backlog would start them
+	// already terminated.
+	if(endedCount){
 
-				// if delay has elapsed, go to next stage
-				if(!((*activeLEDs[i]).holdTime)){
-					(*activeLEDs[i]).fadeLevel = ((*activeLEDs[i]).fadeOutTableSize)-1;
-					(*activeLEDs[i]).stage = fadeOut;
-				}
+		channel_t done = 0;
 
-				else{
-					((*activeLEDs[i]).holdTime)--;
-				}
+		while((done < endedCount) && frameBudget){
+			frameBudget--;
+			replace_led(endedLEDs[done++], now);
+		}
 
-				break;
+		endedCount -= done;
+		memmove(endedLEDs, &endedLEDs[done], endedCount * sizeof(channel_t));
+	}
 
+	// leds whose start delay or hold ended since the last frame move on to
+	// their next stage, the rest of each slot is a lap or more away and stays
+	// put. A gap of a whole turn or more visits every slot once.
+	if(ticks > DISPLAY_WHEEL_SLOTS){
+		ticks = DISPLAY_WHEEL_SLOTS;
+	}
 
-			case fadeOut :
+	while(ticks--){
 
-				// if lowest brightness has been reached go to next stage
-				if((*activeLEDs[i]).fadeLevel <= 0){
-					*((*activeLEDs[i]).brightness) = 0x0000;
-					(*activeLEDs[i]).stage = terminated;
-				}
+		channel_t *link = &wheelHead[(now - ticks) & WHEEL_MASK];
 
-				else{
-					*((*activeLEDs[i]).brightness) = (*activeLEDs[i]).fadeOutTable[(*activeLEDs[i]).fadeLevel];
-					((*activeLEDs[i]).fadeLevel)--;
-				}
+		while(*link != NO_CHANNEL){
 
-				break;
+			channel_t channel = *link;
 
-			case terminated :
+			if((int16_t)(ledDeadline[channel] - now) > 0){
+				link = &ledNext[channel];
+				continue;
+			}
 
-				// replace terminated led with randomly select inactive led
-				replace_led(&activeLEDs[i], &(inactiveLEDs[PRNG(0,TOTAL_CHANNELS-ACTIVE_LEDS)]));
-				break;
+			*link = ledNext[channel];
+			place_led(channel);
 
 		}
 
 	}
 
+	// start a led if fewer than activeTarget are lit
+	if((activeCount < activeTarget) && frameBudget){
+		frameBudget--;
+		activate_led();
+	}
+
+	// step the fading leds along their curves, a led whose fade ran out is
+	// placed again, which renders it. Fade outs are walked last first and
+	// hand a freed slot to the last one, which was already rendered.
+	for(channel_t i=fadeOutCount; i--; ){
+
+		channel_t channel = fadeOutLEDs[i];
+		uint8_t curve = ledFadeOut[channel];
+		int16_t t = now - ledDeadline[channel];
+
+		// fade out runs the curve backwards, from the peak down to 0
+		if(t < FADE_STEPS(curve)){
+			render_channel(channel, fade_level(curve, FADE_STEPS(curve) - 1 - t, 256 - frac));
+			continue;
+		}
+
+		fadeOutLEDs[i] = fadeOutLEDs[--fadeOutCount];
+		place_led(channel);
+
+	}
+
+	// fade ins are walked first to last, a freed slot takes the last one,
+	// which has not been rendered yet. Replacements that are already due
+	// are added at the end, so they are rendered this frame too.
+	for(channel_t i=0; i<fadeInCount; ){
+
+		channel_t channel = fadeInLEDs[i];
+		uint8_t curve = ledFadeIn[channel];
+		int16_t t = now - ledStart[channel];
+
+		if(t < FADE_STEPS(curve)){
+			render_channel(channel, fade_level(curve, t, frac));
+			i++;
+			continue;
+		}
+
+		fadeInLEDs[i] = fadeInLEDs[--fadeInCount];
+		place_led(channel);
+
+	}
+
 }
 
 
 
-void clear_leds(void){
+#ifdef DISPLAY_PROFILE
+// Count a frame time in the histogram. A full bin halves every bin, which
+// keeps the shape and so the percentiles.
+void profile_frame(uint16_t ticks){
 
-	for(uint8_t i = 0; i<TOTAL_CHANNELS; i++){
-			LEDBuffer[i] = 0x0000;
+	uint16_t bin = ticks / DISPLAY_PROFILE_BIN_TICKS;
 
+	if(bin >= DISPLAY_PROFILE_BINS){
+		bin = DISPLAY_PROFILE_BINS - 1;
+	}
+
+	if(++displayProfileHist[bin] == 0xFFFF){
+		for(uint8_t b = 0; b < DISPLAY_PROFILE_BINS; b++){
+			displayProfileHist[b] >>= 1;
+		}
 	}
 
-	// memset(LEDBuffer, 0, sizeof(uint16_t)*TOTAL_CHANNELS);
-	spi_write(LEDBuffer, NUM_DRIVERS, 1);
+}
+
+
+// Frame time that percent of the profiled frames finished within, in Timer0
+// ticks, rounded up to a whole bin. The last bin also holds every longer frame.
+uint16_t display_profile_percentile(uint8_t percent){
+
+	uint32_t total = 0;
+
+	for(uint8_t b = 0; b < DISPLAY_PROFILE_BINS; b++){
+		total += displayProfileHist[b];
+	}
+
+	uint32_t want = (total * percent + 99) / 100;
+
+	for(uint8_t b = 0; b < DISPLAY_PROFILE_BINS; b++){
+		if(displayProfileHist[b] >= want){
+			return (b + 1) * DISPLAY_PROFILE_BIN_TICKS;
+		}
+		want -= displayProfileHist[b];
+	}
+
+	return DISPLAY_PROFILE_BINS * DISPLAY_PROFILE_BIN_TICKS;
+
+}
+#endif
+
+
+
+void clear_leds(void){
+
+	// the last frame may still be shifting out of frontFrame
+	spi_wait();
+
+	// zero every PWM slot and blank the outputs
+	memset(frontFrame, 0, FRAME_BYTES);
+	memset(backFrame, 0, FRAME_BYTES);
+	memset(dirtyDrivers, 0, sizeof(dirtyDrivers));
+	frameDirty = 0;
+	spi_set_header(frontFrame, NUM_DRIVERS, 1);
+	spi_write(frontFrame, FRAME_BYTES);
 
 }
 
 
 
 
-uint8_t PRNG (uint8_t min, uint8_t max){
-	uint8_t value;
-	value = ((uint8_t)((double)rand() / ((double)RAND_MAX) * (max - min))) + min;
+// Random value in [min, max)
+channel_t PRNG (channel_t min, channel_t max){
+	channel_t value;
+	value = prng_range(max - min) + min;
 	return value;
 
 }
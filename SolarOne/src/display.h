@@ -15,9 +15,14 @@
 #ifndef F_CPU
 #define F_CPU 16000000
 #endif
+#ifndef NUM_DRIVERS
 #define NUM_DRIVERS 2								// Number of LED driver chips that are being used. Chip being used is ________
+#endif
 #define TOTAL_CHANNELS (12 * NUM_DRIVERS) 			// Total number of LEDs that are going to be active
-#define ACTIVE_LEDS 12								// The number of flys that will be active at any given time
+#define FRAME_BYTES SPI_FRAME_BYTES(NUM_DRIVERS)	// Bytes in one wire-order frame
+#ifndef ACTIVE_LEDS
+#define ACTIVE_LEDS 12								// The most flys active at any given time, and the default
+#endif
 // #define UPDATE_DELAY 20								// Delay between updates in milliseconds
 
 
@@ -29,130 +34,64 @@
 #include <util/delay_basic.h>
 #include <stdbool.h>
 #include "TLC59711.h"
+#include "clock.h"
+#include "fades.h"
+#include "prng.h"
+
+#if (SPI_BACKEND == SPI_BACKEND_PARALLEL) && (NUM_DRIVERS % SPI_CHAINS)
+#error "NUM_DRIVERS must split evenly across SPI_CHAINS"
+#endif
+
+// clock_ms() counts Timer0 overflows in an ISR. A frame shifted with interrupts
+// masked must fit between two overflows, a second one would be lost and the
+// animation would slow down as the chain grows.
+#if (NUM_DRIVERS * SPI_BYTES_PER_DRIVER * SPI_CYCLES_PER_BYTE) >= (256L * CLOCK_PRESCALE)
+#error "a masked frame spans two Timer0 overflows, reduce NUM_DRIVERS or add SPI_CHAINS"
+#endif
 #include <string.h>
 
+#if (NUM_DRIVERS < 1) || (NUM_DRIVERS > 255)
+#error "NUM_DRIVERS must be 1..255"
+#endif
+
+#if (ACTIVE_LEDS < 1) || (ACTIVE_LEDS >= TOTAL_CHANNELS)
+#error "ACTIVE_LEDS must leave at least one inactive channel"
+#endif
+
+// Channel index, only as wide as the chain needs
+#if TOTAL_CHANNELS > 255
+typedef uint16_t channel_t;
+#define CHANNEL_BYTES 2
+#else
+typedef uint8_t channel_t;
+#define CHANNEL_BYTES 1
+#endif
+
 
-static const uint16_t fade60[61] = {0x0000, 0x0442, 0x0884, 0x0CC6, 0x1108, 0x154A,
-							 		0x198C, 0x1DCE, 0x2210, 0x2652, 0x2A94, 0x2ED6,
-							 		0x3318, 0x375A, 0x3B9C, 0x3FDE, 0x4420, 0x4862,
-							 		0x4CA4, 0x50E6, 0x5528, 0x596A, 0x5DAC, 0x61EE,
-							 		0x6630, 0x6A72, 0x6EB4, 0x72F6, 0x7738, 0x7B7A,
-							 		0x7FBC, 0x83FE, 0x8840, 0x8C82, 0x90C4, 0x9506,
-							 		0x9948, 0x9D8A, 0xA1CC, 0xA60E, 0xAA50, 0xAE92,
-							 		0xB2D4, 0xB716, 0xBB58, 0xBF9A, 0xC3DC, 0xC81E,
-							 		0xCC60, 0xD0A2, 0xD4E4, 0xD926, 0xDD68, 0xE1AA,
-							 		0xE5EC, 0xEA2E, 0xEE70, 0xF2B2, 0xF6F4, 0xFB36,
-							 		0xFF78};
-
-static const uint16_t fade90[101] = {0x0000, 0x028E, 0x051C, 0x07AA, 0x0A38, 0x0CC6,
-							  		 0x0F54, 0x11E2, 0x1470, 0x16FE, 0x198C, 0x1C1A,
-							  		 0x1EA8, 0x2136, 0x23C4, 0x2652, 0x28E0, 0x2B6E,
-							  		 0x2DFC, 0x308A, 0x3318, 0x35A6, 0x3834, 0x3AC2,
-							  		 0x3D50, 0x3FDE, 0x426C, 0x44FA, 0x4788, 0x4A16,
-							  		 0x4CA4, 0x4F32, 0x51C0, 0x544E, 0x56DC, 0x596A,
-							  		 0x5BF8, 0x5E86, 0x6114, 0x63A2, 0x6630, 0x68BE,
-							  		 0x6B4C, 0x6DDA, 0x7068, 0x72F6, 0x7584, 0x7812,
-							  		 0x7AA0, 0x7D2E, 0x7FBC, 0x824A, 0x84D8, 0x8766,
-							  		 0x89F4, 0x8C82, 0x8F10, 0x919E, 0x942C, 0x96BA,
-							  		 0x9948, 0x9BD6, 0x9E64, 0xA0F2, 0xA380, 0xA60E,
-							  		 0xA89C, 0xAB2A, 0xADB8, 0xB046, 0xB2D4, 0xB562,
-							  		 0xB7F0, 0xBA7E, 0xBD0C, 0xBF9A, 0xC228, 0xC4B6,
-							  		 0xC744, 0xC9D2, 0xCC60, 0xCEEE, 0xD17C, 0xD40A,
-							  		 0xD698, 0xD926, 0xDBB4, 0xDE42, 0xE0D0, 0xE35E,
-							  		 0xE5EC, 0xE87A, 0xEB08, 0xED96, 0xF024, 0xF2B2,
-							  		 0xF540, 0xF7CE, 0xFA5C, 0xFCEA, 0xFF78};
-
-static const uint16_t fade120[121] = {0x0000, 0x0221, 0x0442, 0x0663, 0x0884, 0x0AA5,
-							   		  0x0CC6, 0x0EE7, 0x1108, 0x1329, 0x154A, 0x176B,
-							   		  0x198C, 0x1BAD, 0x1DCE, 0x1FEF, 0x2210, 0x2431,
-							   		  0x2652, 0x2873, 0x2A94, 0x2CB5, 0x2ED6, 0x30F7,
-							   		  0x3318, 0x3539, 0x375A, 0x397B, 0x3B9C, 0x3DBD,
-							   		  0x3FDE, 0x41FF, 0x4420, 0x4641, 0x4862, 0x4A83,
-							   		  0x4CA4, 0x4EC5, 0x50E6, 0x5307, 0x5528, 0x5749,
-							   		  0x596A, 0x5B8B, 0x5DAC, 0x5FCD, 0x61EE, 0x640F,
-							   		  0x6630, 0x6851, 0x6A72, 0x6C93, 0x6EB4, 0x70D5,
-							   		  0x72F6, 0x7517, 0x7738, 0x7959, 0x7B7A, 0x7D9B,
-							   		  0x7FBC, 0x81DD, 0x83FE, 0x861F, 0x8840, 0x8A61,
-							   		  0x8C82, 0x8EA3, 0x90C4, 0x92E5, 0x9506, 0x9727,
-							   		  0x9948, 0x9B69, 0x9D8A, 0x9FAB, 0xA1CC, 0xA3ED,
-							   		  0xA60E, 0xA82F, 0xAA50, 0xAC71, 0xAE92, 0xB0B3,
-							   		  0xB2D4, 0xB4F5, 0xB716, 0xB937, 0xBB58, 0xBD79,
-							   		  0xBF9A, 0xC1BB, 0xC3DC, 0xC5FD, 0xC81E, 0xCA3F,
-							   		  0xCC60, 0xCE81, 0xD0A2, 0xD2C3, 0xD4E4, 0xD705,
-							   		  0xD926, 0xDB47, 0xDD68, 0xDF89, 0xE1AA, 0xE3CB,
-							   		  0xE5EC, 0xE80D, 0xEA2E, 0xEC4F, 0xEE70, 0xF091,
-							   		  0xF2B2, 0xF4D3, 0xF6F4, 0xF915, 0xFB36, 0xFD57,
-							   		  0xFF78};
-
-static const uint16_t fade150[151] = {0x0000, 0x01B4, 0x0368, 0x051C, 0x06D0, 0x0884,
-							   		  0x0A38, 0x0BEC, 0x0DA0, 0x0F54, 0x1108, 0x12BC,
-							   		  0x1470, 0x1624, 0x17D8, 0x198C, 0x1B40, 0x1CF4,
-							   		  0x1EA8, 0x205C, 0x2210, 0x23C4, 0x2578, 0x272C,
-							   		  0x28E0, 0x2A94, 0x2C48, 0x2DFC, 0x2FB0, 0x3164,
-							   		  0x3318, 0x34CC, 0x3680, 0x3834, 0x39E8, 0x3B9C,
-							   		  0x3D50, 0x3F04, 0x40B8, 0x426C, 0x4420, 0x45D4,
-							   		  0x4788, 0x493C, 0x4AF0, 0x4CA4, 0x4E58, 0x500C,
-							   		  0x51C0, 0x5374, 0x5528, 0x56DC, 0x5890, 0x5A44,
-							   		  0x5BF8, 0x5DAC, 0x5F60, 0x6114, 0x62C8, 0x647C,
-							   		  0x6630, 0x67E4, 0x6998, 0x6B4C, 0x6D00, 0x6EB4,
-							   		  0x7068, 0x721C, 0x73D0, 0x7584, 0x7738, 0x78EC,
-							   		  0x7AA0, 0x7C54, 0x7E08, 0x7FBC, 0x8170, 0x8324,
-							   		  0x84D8, 0x868C, 0x8840, 0x89F4, 0x8BA8, 0x8D5C,
-							   		  0x8F10, 0x90C4, 0x9278, 0x942C, 0x95E0, 0x9794,
-							   		  0x9948, 0x9AFC, 0x9CB0, 0x9E64, 0xA018, 0xA1CC,
-							   		  0xA380, 0xA534, 0xA6E8, 0xA89C, 0xAA50, 0xAC04,
-							   		  0xADB8, 0xAF6C, 0xB120, 0xB2D4, 0xB488, 0xB63C,
-							   		  0xB7F0, 0xB9A4, 0xBB58, 0xBD0C, 0xBEC0, 0xC074,
-							   		  0xC228, 0xC3DC, 0xC590, 0xC744, 0xC8F8, 0xCAAC,
-							   		  0xCC60, 0xCE14, 0xCFC8, 0xD17C, 0xD330, 0xD4E4,
-							   		  0xD698, 0xD84C, 0xDA00, 0xDBB4, 0xDD68, 0xDF1C,
-							   		  0xE0D0, 0xE284, 0xE438, 0xE5EC, 0xE7A0, 0xE954,
-							   		  0xEB08, 0xECBC, 0xEE70, 0xF024, 0xF1D8, 0xF38C,
-							   		  0xF540, 0xF6F4, 0xF8A8, 0xFA5C, 0xFC10, 0xFDC4,
-							   		  0xFF78};
-
-static const uint16_t fade180[201] = {0x0000, 0x0147, 0x028E, 0x03D5, 0x051C, 0x0663,
-							   		  0x07AA, 0x08F1, 0x0A38, 0x0B7F, 0x0CC6, 0x0E0D,
-							   		  0x0F54, 0x109B, 0x11E2, 0x1329, 0x1470, 0x15B7,
-							   		  0x16FE, 0x1845, 0x198C, 0x1AD3, 0x1C1A, 0x1D61,
-							   		  0x1EA8, 0x1FEF, 0x2136, 0x227D, 0x23C4, 0x250B,
-							   		  0x2652, 0x2799, 0x28E0, 0x2A27, 0x2B6E, 0x2CB5,
-							   		  0x2DFC, 0x2F43, 0x308A, 0x31D1, 0x3318, 0x345F,
-							   		  0x35A6, 0x36ED, 0x3834, 0x397B, 0x3AC2, 0x3C09,
-							   		  0x3D50, 0x3E97, 0x3FDE, 0x4125, 0x426C, 0x43B3,
-							   		  0x44FA, 0x4641, 0x4788, 0x48CF, 0x4A16, 0x4B5D,
-							   		  0x4CA4, 0x4DEB, 0x4F32, 0x5079, 0x51C0, 0x5307,
-							   		  0x544E, 0x5595, 0x56DC, 0x5823, 0x596A, 0x5AB1,
-							   		  0x5BF8, 0x5D3F, 0x5E86, 0x5FCD, 0x6114, 0x625B,
-							   		  0x63A2, 0x64E9, 0x6630, 0x6777, 0x68BE, 0x6A05,
-							   		  0x6B4C, 0x6C93, 0x6DDA, 0x6F21, 0x7068, 0x71AF,
-							   		  0x72F6, 0x743D, 0x7584, 0x76CB, 0x7812, 0x7959,
-							   		  0x7AA0, 0x7BE7, 0x7D2E, 0x7E75, 0x7FBC, 0x8103,
-							   		  0x824A, 0x8391, 0x84D8, 0x861F, 0x8766, 0x88AD,
-							   		  0x89F4, 0x8B3B, 0x8C82, 0x8DC9, 0x8F10, 0x9057,
-							   		  0x919E, 0x92E5, 0x942C, 0x9573, 0x96BA, 0x9801,
-							   		  0x9948, 0x9A8F, 0x9BD6, 0x9D1D, 0x9E64, 0x9FAB,
-							   		  0xA0F2, 0xA239, 0xA380, 0xA4C7, 0xA60E, 0xA755,
-							   		  0xA89C, 0xA9E3, 0xAB2A, 0xAC71, 0xADB8, 0xAEFF,
-							   		  0xB046, 0xB18D, 0xB2D4, 0xB41B, 0xB562, 0xB6A9,
-							   		  0xB7F0, 0xB937, 0xBA7E, 0xBBC5, 0xBD0C, 0xBE53,
-							   		  0xBF9A, 0xC0E1, 0xC228, 0xC36F, 0xC4B6, 0xC5FD,
-							   		  0xC744, 0xC88B, 0xC9D2, 0xCB19, 0xCC60, 0xCDA7,
-							   		  0xCEEE, 0xD035, 0xD17C, 0xD2C3, 0xD40A, 0xD551,
-							   		  0xD698, 0xD7DF, 0xD926, 0xDA6D, 0xDBB4, 0xDCFB,
-							   		  0xDE42, 0xDF89, 0xE0D0, 0xE217, 0xE35E, 0xE4A5,
-							   		  0xE5EC, 0xE733, 0xE87A, 0xE9C1, 0xEB08, 0xEC4F,
-							   		  0xED96, 0xEEDD, 0xF024, 0xF16B, 0xF2B2, 0xF3F9,
-							   		  0xF540, 0xF687, 0xF7CE, 0xF915, 0xFA5C, 0xFBA3,
-							   		  0xFCEA, 0xFE31, 0xFF78};
-
-
-// all fade tables
-static const uint16_t *fade[]={fade60, fade90, fade120, fade150, fade180};
-static const uint8_t tableSizes[5]= {61,101,121,151,201};
-
-
-// led stages
+// Fades follow the gamma curves generated into fades.h/fades.c by
+// tools/fadegen.py. Each step adds one delta byte read from flash, shifted
+// up by the curve's scale, to the last whole level stored in fadeMarks.
+#define FADE_STEPS(curve) pgm_read_byte(&fadeCurves[curve].steps)
+#define FADE_DELTA(curve, i) ((uint16_t)pgm_read_byte(&fadeDeltas[pgm_read_word(&fadeCurves[curve].offset) + (i)])\
+							  << pgm_read_byte(&fadeCurves[curve].shift))
+#define FADE_MARK(curve, i) pgm_read_word(&fadeMarks[pgm_read_byte(&fadeCurves[curve].mark) + ((i) / FADE_MARK_STEPS)])
+
+
+// Animation is timed by clock_ms(), not by how often frames are rendered. A
+// tick of the timeline is one fade step of DISPLAY_STEP_US, frames that land
+// between two steps interpolate the fade.
+#ifndef DISPLAY_STEP_US
+#define DISPLAY_STEP_US 5500						// about one pass of the old 5ms delay loop
+#endif
+#define DISPLAY_STEP_RATE ((65536000UL + DISPLAY_STEP_US/2) / DISPLAY_STEP_US)	// steps per ms, 16 fraction bits
+
+#if DISPLAY_STEP_US <= 1000
+#error "DISPLAY_STEP_US must be over 1ms"
+#endif
+
+// led stages. A started led's stage and brightness are a function of the
+// tick alone, see led_state: it waits out its start delay, fades in, holds
+// and fades out, then is terminated and replaced.
 enum stage{
 
 	ready,
@@ -164,26 +103,137 @@ enum stage{
 
 };
 
-// Array of LEDs
+// Started leds are kept by stage. Leds waiting out a start delay or hold sit
+// in a timer wheel until their deadline, leds fading in or out in a list per
+// fade, so a frame only visits the wheel slots for the ticks since the last
+// frame and the fading leds. Slot = deadline % DISPLAY_WHEEL_SLOTS,
+// a wait longer than one turn just stays in its slot for another lap.
+#ifndef DISPLAY_WHEEL_SLOTS
+#define DISPLAY_WHEEL_SLOTS 32
+#endif
+#define WHEEL_MASK (DISPLAY_WHEEL_SLOTS - 1)
+#define NO_CHANNEL ((channel_t)~0)					// end of a wheel list
+
+#if (DISPLAY_WHEEL_SLOTS < 1) || (DISPLAY_WHEEL_SLOTS & WHEEL_MASK)
+#error "DISPLAY_WHEEL_SLOTS must be a power of two"
+#endif
+
+#if TOTAL_CHANNELS >= (1UL << (8 * CHANNEL_BYTES)) - 1
+#error "channel_t needs a spare value for NO_CHANNEL"
+#endif
+
+// LED state, one array per field indexed by channel. The current brightness
+// is not stored, led_state works it out from the tick.
+#define LED_STATE_BYTES (7 + CHANNEL_BYTES)			// Bytes of state per channel
+
+extern uint8_t *frontFrame;	// complete wire-order frame, read by the transport
+extern uint8_t *backFrame;	// wire-order frame being rendered by update_display
+extern uint16_t ledStart[TOTAL_CHANNELS];			// start delay until the led is started, then the tick fade in begins
+extern uint8_t ledHold[TOTAL_CHANNELS];				// ticks at full brightness between the fades
+extern uint8_t ledFadeIn[TOTAL_CHANNELS];			// fade curve ids, see fades.h
+extern uint8_t ledFadeOut[TOTAL_CHANNELS];
+extern uint16_t ledDeadline[TOTAL_CHANNELS];		// tick the current wait ends, while fading out the tick it began
+extern channel_t ledNext[TOTAL_CHANNELS];			// next led in the same wheel slot
+extern channel_t wheelHead[DISPLAY_WHEEL_SLOTS];	// first led of each wheel slot
+extern channel_t fadeInLEDs[ACTIVE_LEDS];			// leds fading in, the first fadeInCount are used
+extern channel_t fadeInCount;
+extern channel_t fadeOutLEDs[ACTIVE_LEDS];			// leds fading out, the first fadeOutCount are used
+extern channel_t fadeOutCount;
+extern channel_t activeCount;						// leds lit or waiting, taken from the pool
+extern channel_t endedLEDs[ACTIVE_LEDS];			// terminated leds waiting for a frame with budget
+extern channel_t endedCount;
+extern uint16_t displayTick;						// tick of the last update_display
+extern channel_t activeTarget;						// activeCount update_display works toward, see set_active_leds
+
+// Channel pool, one bit per channel, set while the channel is active. Bits
+// past TOTAL_CHANNELS stay set so they are never picked. pool_select finds
+// the n-th clear bit by counting whole bytes, four bits per flash lookup.
+#define POOL_BYTES ((TOTAL_CHANNELS + 7) / 8)
+#define POOL_TAKE(channel) (ledPool[(channel) >> 3] |= (1 << ((channel) & 7)))
+#define POOL_FREE(channel) (ledPool[(channel) >> 3] &= ~(1 << ((channel) & 7)))
+#define POOL_TAKEN(channel) (ledPool[(channel) >> 3] & (1 << ((channel) & 7)))
+#define POOL_FREE_BITS(bits) (pgm_read_byte(&nibbleFree[(bits) & 0x0F]) + pgm_read_byte(&nibbleFree[(bits) >> 4]))
+
+extern uint8_t ledPool[POOL_BYTES];
+extern const uint8_t nibbleFree[16] PROGMEM;
+
+// Parameters of one lifecycle. Replacements take theirs from a ring that
+// display_idle fills between frames, so update_display does not draw them.
 typedef struct{
-	
-	uint8_t startDelayTime;		
-	uint8_t holdTime;
-	uint16_t *fadeInTable;
-	uint16_t *fadeOutTable;
-	uint8_t fadeLevel;
-	uint8_t fadeInTableSize;
-	uint8_t fadeOutTableSize;
-	uint16_t *brightness;
-	enum stage stage;
 
-}led;
+	uint8_t delay;				// start delay, in ticks
+	uint8_t hold;				// ticks at full brightness
+	uint8_t fadeIn;				// fade curve ids, see fades.h
+	uint8_t fadeOut;
+
+}led_params;
+
+#ifndef DISPLAY_PARAM_RING
+#define DISPLAY_PARAM_RING 8						// Parameter sets kept ready, a power of two
+#endif
+#define PARAM_RING_MASK (DISPLAY_PARAM_RING - 1)
+
+#if (DISPLAY_PARAM_RING < 1) || (DISPLAY_PARAM_RING > 128) || (DISPLAY_PARAM_RING & PARAM_RING_MASK)
+#error "DISPLAY_PARAM_RING must be a power of two up to 128"
+#endif
+
+// Work allowed per frame, so no frame takes much longer than the rest.
+// Replacements (and starts while activeCount is under the target) past the
+// budget wait for a later frame, the led stays dark meanwhile and its
+// replacement starts when it is made. The budget is DISPLAY_FRAME_BUDGET per
+// tick since the last frame, so replacements keep up with time, but never
+// over DISPLAY_FRAME_BUDGET_MAX. Frames work a backlog off at the maximum.
+// display_idle draws at most DISPLAY_REFILL_BUDGET parameter sets per call.
+#ifndef DISPLAY_FRAME_BUDGET
+#define DISPLAY_FRAME_BUDGET 2
+#endif
+#ifndef DISPLAY_FRAME_BUDGET_MAX
+#define DISPLAY_FRAME_BUDGET_MAX 8
+#endif
+#ifndef DISPLAY_REFILL_BUDGET
+#define DISPLAY_REFILL_BUDGET 2
+#endif
 
+#if (DISPLAY_FRAME_BUDGET < 1) || (DISPLAY_FRAME_BUDGET > 255) || (DISPLAY_REFILL_BUDGET < 1) || (DISPLAY_REFILL_BUDGET > 255)
+#error "DISPLAY_FRAME_BUDGET and DISPLAY_REFILL_BUDGET must be 1..255"
+#endif
+
+#if (DISPLAY_FRAME_BUDGET_MAX < DISPLAY_FRAME_BUDGET) || (DISPLAY_FRAME_BUDGET_MAX > 255)
+#error "DISPLAY_FRAME_BUDGET_MAX must be DISPLAY_FRAME_BUDGET..255"
+#endif
 
-uint16_t *LEDBuffer;
-led *LEDs;
-led *activeLEDs[ACTIVE_LEDS];
-led *inactiveLEDs[TOTAL_CHANNELS-ACTIVE_LEDS];
+// Display state is all static, sized here so a chain that can't fit fails the build.
+// The 23 bytes are the frame pointers, frameDirty, the frame counters, the
+// timeline clock, the parameter ring's head and count and the frame budget. The reserve covers
+// the stack, the uart buffers and main.c's globals.
+#define DISPLAY_RAM_BYTES (2*FRAME_BYTES + LED_STATE_BYTES*TOTAL_CHANNELS \
+						   + CHANNEL_BYTES*(3*ACTIVE_LEDS + DISPLAY_WHEEL_SLOTS + 5) \
+						   + POOL_BYTES + (NUM_DRIVERS+7)/8 + 4*DISPLAY_PARAM_RING + 23)
+#define DISPLAY_RAM_RESERVE 512
+
+#if defined(__AVR__) && (DISPLAY_RAM_BYTES > (RAMEND - RAMSTART + 1 - DISPLAY_RAM_RESERVE))
+#error "display state does not fit in SRAM, reduce NUM_DRIVERS"
+#endif
+
+// Frame statistics, see write_display
+extern uint32_t framesSent;
+extern uint32_t framesSkipped;
+
+// Build with -DDISPLAY_PROFILE to time update_display in Timer0 ticks (CLOCK_PRESCALE
+// cycles), summed by the number of leds fading after the frame. Mean cycles per frame
+// with n leds fading = displayProfileTicks[n] * CLOCK_PRESCALE / displayProfileFrames[n].
+//
+// The same builds keep a histogram of update_display times in bins of
+// DISPLAY_PROFILE_BIN_TICKS, for display_profile_percentile (p50/p99).
+#ifdef DISPLAY_PROFILE
+#define DISPLAY_PROFILE_BINS 64
+#define DISPLAY_PROFILE_BIN_TICKS 1					// 256 cycles, 16us at 16MHz
+extern uint32_t displayProfileTicks[ACTIVE_LEDS + 1];
+extern uint32_t displayProfileFrames[ACTIVE_LEDS + 1];
+extern uint16_t displayProfileHist[DISPLAY_PROFILE_BINS];
+void profile_frame(uint16_t ticks);
+uint16_t display_profile_percentile(uint8_t percent);
+#endif
 
 // random seed
 
@@ -191,13 +241,28 @@ led *inactiveLEDs[TOTAL_CHANNELS-ACTIVE_LEDS];
 // Function Prototypes
 void display_init(void);
 void write_display(void);
-void update_display(void);
+void update_display(uint16_t now, uint8_t frac);
 void setup_display(void);
-led make_led(uint8_t index);
-void refresh_led(led *deadLED);
-void replace_led(led **deadLED, led **freshLED);
-uint8_t PRNG (uint8_t min, uint8_t max);
+void make_led(channel_t index);
+void refresh_led(channel_t deadLED);
+void draw_params(led_params *params);
+void load_params(channel_t channel, const led_params *params);
+void display_idle(void);
+void fill_params(uint8_t count);
+void end_led(channel_t channel);
+void replace_led(channel_t deadLED, uint16_t tick);
+void activate_led(void);
+void start_led(channel_t channel, uint16_t tick);
+void wait_led(channel_t channel, uint16_t deadline);
+void place_led(channel_t channel);
+uint8_t led_state(channel_t channel, uint16_t now, uint8_t frac, uint16_t *brightness);
+uint16_t fade_level(uint8_t curve, uint8_t step, uint16_t weight);
+void set_active_leds(channel_t count);
+channel_t pool_select(channel_t rank);
+channel_t PRNG (channel_t min, channel_t max);
 void clear_leds(void);
+void swap_frames(void);
+void render_channel(channel_t channel, uint16_t brightness);
 
 
 #endif // DISPLAY_H
@@ -0,0 +1,110 @@
+/*
+ * fades.c
+ *
+ * Generated by fadegen.py --gamma 2.2 --max 0xFF78 60 100 120 150 200, do not edit
+ *
+ */
+
+#include "fades.h"
+
+const fade_curve fadeCurves[NUM_FADES] PROGMEM = {
+	{0, 60, 4, 0},
+	{60, 100, 3, 8},
+	{160, 120, 3, 21},
+	{280, 150, 2, 36},
+	{430, 200, 2, 55},
+};
+
+const uint8_t fadeDeltas[FADE_DATA_BYTES] PROGMEM = {
+
+	// 60 steps, << 4
+	0x01, 0x01, 0x04, 0x05, 0x06, 0x09, 0x0A, 0x0D, 0x0E, 0x10, 0x13, 0x14,
+	0x17, 0x19, 0x1C, 0x1D, 0x20, 0x22, 0x25, 0x27, 0x29, 0x2C, 0x2E, 0x30,
+	0x34, 0x35, 0x38, 0x3B, 0x3E, 0x3F, 0x43, 0x45, 0x48, 0x4A, 0x4E, 0x4F,
+	0x53, 0x55, 0x58, 0x5B, 0x5D, 0x61, 0x63, 0x66, 0x68, 0x6C, 0x6E, 0x72,
+	0x74, 0x77, 0x79, 0x7D, 0x80, 0x82, 0x86, 0x88, 0x8C, 0x8E, 0x92, 0x94,
+
+	// 100 steps, << 3
+	0x00, 0x01, 0x03, 0x03, 0x04, 0x06, 0x07, 0x08, 0x09, 0x0B, 0x0C, 0x0D,
+	0x0F, 0x10, 0x12, 0x13, 0x15, 0x16, 0x18, 0x19, 0x1B, 0x1C, 0x1E, 0x20,
+	0x21, 0x23, 0x25, 0x26, 0x28, 0x29, 0x2B, 0x2D, 0x2F, 0x31, 0x32, 0x34,
+	0x35, 0x38, 0x39, 0x3B, 0x3D, 0x3E, 0x41, 0x42, 0x44, 0x46, 0x48, 0x49,
+	0x4C, 0x4D, 0x4F, 0x51, 0x53, 0x55, 0x57, 0x59, 0x5A, 0x5D, 0x5E, 0x61,
+	0x62, 0x65, 0x66, 0x68, 0x6A, 0x6D, 0x6E, 0x70, 0x72, 0x74, 0x77, 0x78,
+	0x7A, 0x7C, 0x7F, 0x80, 0x83, 0x84, 0x86, 0x89, 0x8B, 0x8C, 0x8F, 0x91,
+	0x93, 0x95, 0x97, 0x99, 0x9B, 0x9E, 0x9F, 0xA2, 0xA4, 0xA6, 0xA8, 0xAA,
+	0xAC, 0xAF, 0xB0, 0xB3,
+
+	// 120 steps, << 3
+	0x00, 0x01, 0x01, 0x03, 0x03, 0x03, 0x05, 0x05, 0x06, 0x08, 0x08, 0x09,
+	0x0A, 0x0A, 0x0C, 0x0D, 0x0E, 0x0F, 0x10, 0x11, 0x12, 0x13, 0x14, 0x15,
+	0x16, 0x18, 0x18, 0x1A, 0x1A, 0x1C, 0x1D, 0x1E, 0x1F, 0x21, 0x21, 0x23,
+	0x24, 0x25, 0x27, 0x27, 0x29, 0x2A, 0x2B, 0x2C, 0x2E, 0x2F, 0x30, 0x31,
+	0x32, 0x34, 0x35, 0x37, 0x37, 0x39, 0x3A, 0x3B, 0x3D, 0x3E, 0x3F, 0x41,
+	0x42, 0x43, 0x45, 0x45, 0x48, 0x48, 0x4A, 0x4B, 0x4C, 0x4E, 0x4F, 0x51,
+	0x52, 0x53, 0x55, 0x55, 0x58, 0x58, 0x5A, 0x5C, 0x5D, 0x5E, 0x60, 0x60,
+	0x63, 0x64, 0x65, 0x66, 0x68, 0x6A, 0x6B, 0x6C, 0x6E, 0x6F, 0x70, 0x72,
+	0x73, 0x75, 0x76, 0x78, 0x79, 0x7B, 0x7C, 0x7D, 0x7F, 0x81, 0x82, 0x83,
+	0x85, 0x86, 0x88, 0x89, 0x8B, 0x8C, 0x8D, 0x90, 0x90, 0x92, 0x94, 0x95,
+
+	// 150 steps, << 2
+	0x00, 0x01, 0x02, 0x03, 0x03, 0x05, 0x05, 0x07, 0x08, 0x08, 0x0A, 0x0B,
+	0x0C, 0x0E, 0x0E, 0x10, 0x11, 0x12, 0x14, 0x14, 0x16, 0x18, 0x18, 0x1A,
+	0x1B, 0x1D, 0x1E, 0x1F, 0x21, 0x22, 0x23, 0x25, 0x27, 0x27, 0x29, 0x2B,
+	0x2C, 0x2D, 0x2F, 0x30, 0x32, 0x34, 0x34, 0x37, 0x37, 0x3A, 0x3B, 0x3C,
+	0x3E, 0x3F, 0x41, 0x43, 0x44, 0x45, 0x47, 0x49, 0x4A, 0x4C, 0x4E, 0x4F,
+	0x50, 0x53, 0x53, 0x56, 0x57, 0x59, 0x5A, 0x5C, 0x5E, 0x5F, 0x61, 0x62,
+	0x65, 0x65, 0x68, 0x69, 0x6B, 0x6D, 0x6E, 0x70, 0x71, 0x74, 0x75, 0x76,
+	0x79, 0x7A, 0x7C, 0x7D, 0x80, 0x81, 0x82, 0x85, 0x86, 0x88, 0x8A, 0x8B,
+	0x8E, 0x8F, 0x90, 0x93, 0x94, 0x96, 0x98, 0x9A, 0x9B, 0x9D, 0x9F, 0xA1,
+	0xA2, 0xA5, 0xA6, 0xA8, 0xAA, 0xAB, 0xAE, 0xAF, 0xB1, 0xB3, 0xB5, 0xB6,
+	0xB8, 0xBB, 0xBC, 0xBE, 0xBF, 0xC2, 0xC3, 0xC6, 0xC7, 0xC9, 0xCB, 0xCC,
+	0xCF, 0xD0, 0xD3, 0xD4, 0xD6, 0xD8, 0xDA, 0xDC, 0xDD, 0xE0, 0xE1, 0xE4,
+	0xE5, 0xE7, 0xE9, 0xEB, 0xED, 0xEF,
+
+	// 200 steps, << 2
+	0x00, 0x01, 0x01, 0x01, 0x02, 0x02, 0x03, 0x04, 0x04, 0x04, 0x06, 0x06,
+	0x06, 0x07, 0x08, 0x08, 0x09, 0x0A, 0x0A, 0x0B, 0x0C, 0x0C, 0x0D, 0x0E,
+	0x0F, 0x0F, 0x10, 0x10, 0x12, 0x12, 0x13, 0x13, 0x14, 0x15, 0x16, 0x17,
+	0x17, 0x18, 0x19, 0x1A, 0x1A, 0x1C, 0x1C, 0x1D, 0x1D, 0x1F, 0x1F, 0x20,
+	0x21, 0x21, 0x23, 0x23, 0x24, 0x25, 0x26, 0x27, 0x27, 0x28, 0x29, 0x2A,
+	0x2B, 0x2C, 0x2D, 0x2D, 0x2E, 0x2F, 0x30, 0x31, 0x32, 0x32, 0x34, 0x34,
+	0x35, 0x36, 0x37, 0x38, 0x39, 0x3A, 0x3A, 0x3C, 0x3C, 0x3D, 0x3E, 0x3F,
+	0x40, 0x41, 0x42, 0x43, 0x43, 0x45, 0x45, 0x47, 0x47, 0x48, 0x49, 0x4A,
+	0x4B, 0x4C, 0x4D, 0x4E, 0x4F, 0x4F, 0x51, 0x52, 0x52, 0x54, 0x54, 0x55,
+	0x57, 0x57, 0x58, 0x59, 0x5B, 0x5B, 0x5C, 0x5D, 0x5E, 0x5F, 0x60, 0x61,
+	0x62, 0x62, 0x64, 0x65, 0x66, 0x67, 0x68, 0x68, 0x6A, 0x6B, 0x6C, 0x6C,
+	0x6E, 0x6F, 0x6F, 0x71, 0x72, 0x73, 0x73, 0x75, 0x76, 0x76, 0x78, 0x79,
+	0x7A, 0x7A, 0x7C, 0x7D, 0x7E, 0x7F, 0x7F, 0x81, 0x82, 0x83, 0x84, 0x85,
+	0x86, 0x87, 0x88, 0x89, 0x8A, 0x8B, 0x8C, 0x8E, 0x8E, 0x8F, 0x90, 0x92,
+	0x92, 0x94, 0x94, 0x96, 0x96, 0x98, 0x99, 0x99, 0x9B, 0x9C, 0x9D, 0x9E,
+	0x9F, 0xA0, 0xA1, 0xA2, 0xA3, 0xA5, 0xA5, 0xA6, 0xA8, 0xA8, 0xAA, 0xAB,
+	0xAC, 0xAC, 0xAE, 0xAF, 0xB0, 0xB2, 0xB2, 0xB3,
+
+};
+
+const uint16_t fadeMarks[FADE_MARKS] PROGMEM = {
+
+	// 60 steps, every 8
+	0x0000, 0x0310, 0x0DF0, 0x2200, 0x4010, 0x68B0, 0x9C60, 0xDB70,
+
+	// 100 steps, every 8
+	0x0000, 0x0100, 0x0488, 0x0B10, 0x14D0, 0x2208, 0x32D0, 0x4758,
+	0x5FB0, 0x7C00, 0x9C58, 0xC0D0, 0xE980,
+
+	// 120 steps, every 8
+	0x0000, 0x00A8, 0x0308, 0x0768, 0x0DF0, 0x16C8, 0x2208, 0x2FC0,
+	0x4010, 0x5308, 0x68B0, 0x8118, 0x9C58, 0xBA70, 0xDB78,
+
+	// 150 steps, every 8
+	0x0000, 0x0068, 0x01DC, 0x0488, 0x0888, 0x0DF0, 0x14D4, 0x1D3C,
+	0x2738, 0x32D0, 0x4014, 0x4F04, 0x5FB0, 0x7220, 0x8654, 0x9C58,
+	0xB434, 0xCDE8, 0xE980,
+
+	// 200 steps, every 8
+	0x0000, 0x0038, 0x00FC, 0x0268, 0x0488, 0x0768, 0x0B10, 0x0F88,
+	0x14D4, 0x1AFC, 0x2208, 0x29F8, 0x32D0, 0x3C9C, 0x4754, 0x5308,
+	0x5FB0, 0x6D58, 0x7C00, 0x8BA8, 0x9C58, 0xAE10, 0xC0D0, 0xD4A0,
+	0xE980,
+
+};
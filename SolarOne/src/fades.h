@@ -0,0 +1,34 @@
+#ifndef FADES_H
+#define FADES_H
+
+/*
+ * fades.h
+ *
+ * Generated by fadegen.py --gamma 2.2 --max 0xFF78 60 100 120 150 200, do not edit
+ *
+ */
+
+#include <avr/pgmspace.h>
+
+#define NUM_FADES 5								// Number of fade curves, ids 0..NUM_FADES-1
+#define FADE_MAX 0xFF70							// Peak of every curve
+#define FADE_DATA_BYTES 630						// Bytes of deltas in fadeDeltas
+#define FADE_MARK_STEPS 8						// Steps between stored levels in fadeMarks
+#define FADE_MARKS 80							// Levels in fadeMarks
+
+// One compressed curve: level i + 1 = level i + (delta i << shift), and
+// level i * FADE_MARK_STEPS is stored whole at fadeMarks[mark + i]
+typedef struct{
+
+	uint16_t offset;			// first delta in fadeDeltas
+	uint8_t steps;				// fade duration, in ticks of DISPLAY_STEP_US
+	uint8_t shift;				// scale of the deltas
+	uint8_t mark;				// first level in fadeMarks
+
+}fade_curve;
+
+extern const fade_curve fadeCurves[NUM_FADES] PROGMEM;
+extern const uint8_t fadeDeltas[FADE_DATA_BYTES] PROGMEM;
+extern const uint16_t fadeMarks[FADE_MARKS] PROGMEM;
+
+#endif // FADES_H
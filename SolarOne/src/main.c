@@ -43,6 +43,7 @@ uint8_t ledsCleared;
 uint8_t displayEnabled;
 uint8_t micro_intialized;
 uint16_t displayCount;
+volatile uint8_t sodCheckDue;
 sod stateOfDay;
 soc stateOfCharge;
 
@@ -86,10 +87,15 @@ soc stateOfCharge;
 #define DEBUG_MODE 0
 #define DEBUG_TRACE_DELAY 10
 
+// USART0 is either the debug UART or the LED transport (SPI_BACKEND_USART), not both
+#if (SPI_BACKEND == SPI_BACKEND_USART) && (DEBUG_MODE != 0)
+#error "DEBUG_MODE requires USART0, select another SPI_BACKEND"
+#endif
+
 // delays (ms)
 #define NUM_SOD_INIT_CHECK_DELAY 10
 #define BATTERY_STABILIZE_DELAY 10
-#define DISPLAY_UPDATE_DELAY 5
+#define DISPLAY_UPDATE_DELAY 5						// frame pacing only, fades are timed by clock_ms()
 
 // counters (minutes)
 #define DISPLAY_DURATION 1  
@@ -134,12 +140,18 @@ soc stateOfCharge;
 #define DISCONNECT_LED_DRIVERS() {(PORTD &= (~(1<<PORTD3)));\
 								  ledDriversConnected=0;\
 								 }
-// PortB, Pin 4 (Arduino GPIO 4)
-#define CONNECT_LEDS() {(PORTD |= (1<<PORTD4));\
+// PortD, Pin 4 (Arduino GPIO 4), PortD, Pin 7 (Arduino GPIO 7) when PD4 is the USART transport clock (XCK0)
+#if SPI_BACKEND == SPI_BACKEND_USART
+#define LEDS_ENABLE PORTD7
+#else
+#define LEDS_ENABLE PORTD4
+#endif
+
+#define CONNECT_LEDS() {(PORTD |= (1<<LEDS_ENABLE));\
 						ledsConnected=1;\
 					   }
 
-#define DISCONNECT_LEDS() {(PORTD &= (~(1<<PORTD4)));\
+#define DISCONNECT_LEDS() {(PORTD &= (~(1<<LEDS_ENABLE)));\
 							ledsConnected=0;\
 						  }
 
@@ -158,7 +170,7 @@ soc stateOfCharge;
 
 void micro_init(void);
 void display_init(void);
-void update_display(void);
+void update_display(uint16_t now, uint8_t frac);
 void update_state_of_charge(void);
 void update_state_of_day(void);
 void start_timer(void);
@@ -170,6 +182,7 @@ void adc_init(void);
 void sculpture_init(void);
 void print(char *s);
 uint16_t adc_read(uint8_t ch);
+uint16_t adc_noise(void);
 soc decode_charge_state(uint16_t ADCValue);
 sod get_majority_day_state_reading(void);
 sod decode_day_state(uint16_t ADCValue);
@@ -297,12 +310,14 @@ int main(void){
 						// display_init(); 
 						CONNECT_LEDS();
 
-						// initialize leds
+						// new random show every night, then initialize leds
+						prng_seed(adc_noise());
 						display_init();
 						ledsCleared = 0;
 
 						// initialize countdown timer seconds
 						displayCount = (DISPLAY_DURATION*60)-1;
+						sodCheckDue = 0;
 						start_timer();
 						
 					}
@@ -312,10 +327,50 @@ int main(void){
 				while(displayEnabled){
 					
 					write_display(); // updates and writes...
+					display_idle();  // draws the next leds' parameters in the slack
+
+					// sod check flagged by the timer isr, done here so the
+					// ADC reads don't hold off the frame transfer
+					if(sodCheckDue){
+						sodCheckDue = 0;
+						sod temp = stateOfDay;
+						update_state_of_day();
+						if(temp != stateOfDay){
+							SET_TRANSTION();
+							DISABLE_DISPLAY();
+						}
+					}
+
 					_delay_ms(DISPLAY_UPDATE_DELAY);
 
 				}
 
+				if(DEBUG_MODE == 2 && displayCount == 0){
+					print("TMR elapsed\n\r");
+				}
+
+#ifdef DISPLAY_PROFILE
+				// frame time percentiles so far, in Timer0 ticks (16us)
+				if(DEBUG_MODE > 0){
+					char digits[6];
+					print("p50 ");
+					print(utoa(display_profile_percentile(50), digits, 10));
+					print(" p99 ");
+					print(utoa(display_profile_percentile(99), digits, 10));
+					print("\n\r");
+				}
+#endif
+
+#ifdef SPI_PROFILE
+				// longest interrupts-masked window, in us
+				if(DEBUG_MODE > 0){
+					char digits[6];
+					print("mask ");
+					print(utoa(spiMaskedMax * SPI_PROFILE_TICK_US, digits, 10));
+					print("\n\r");
+				}
+#endif
+
 				if(!ledsCleared){
 					clear_leds();
 					ledsCleared = 1;
@@ -368,33 +423,23 @@ ISR(WDT_vect)
 *  counter used to control the operating
 *  time of the load.  Once the counter
 *  reaches zero, a flag is toggled to
-*  disable the load. Every 8 cycles check
-*  SOD.
+*  disable the load. Every 8 cycles flag
+*  a SOD check for the display loop.
+*  Must stay under SPI_ISR_MAX_CYCLES,
+*  it can fire while a frame is pumped.
 ***************************************/
 
 ISR(TIMER1_COMPA_vect){
 
-	if(DEBUG_MODE == 2){
-		print("TISR\n\r");
-	}
-
 	--displayCount;
 
 	// to mimic day sleep, check sod every 8 seconds
 	if(displayCount % 8 == 0){
-		sod temp = stateOfDay;
-		update_state_of_day();
-		if(temp != stateOfDay){
-			SET_TRANSTION();
-			DISABLE_DISPLAY();
-		}
+		sodCheckDue = 1;
 	}
 
 	if(displayCount == 0 ){
 
-		if(DEBUG_MODE == 2){
-			print("TMR elapsed\n\r");
-		}
 		// stop timer, via pre-scale clear
 		TCCR1B &= 0xFFF8;
 		DISABLE_DISPLAY();
@@ -725,6 +770,27 @@ uint16_t adc_read(uint8_t ch){
 
 }
 
+/***************************************
+*  Function: adc_noise
+*  -------------------
+*  Folds 16 readings across all six ADC
+*  channels into one word. The low bits
+*  jitter from read to read and seed
+*  the random number generator.
+***************************************/
+
+uint16_t adc_noise(void){
+
+	uint16_t noise = 0;
+
+	for(uint8_t i=0; i<16; i++){
+		noise = ((noise << 3) | (noise >> 13)) ^ adc_read(i % 6);
+	}
+
+	return noise;
+
+}
+
 
 /***************************************
 *  Function: start_timer
@@ -803,7 +869,7 @@ void sculpture_init(void){
 	update_state_of_day();
 
 
-	// allocate memory for led structs and brightness buffer
+	// point the frames at their static buffers
 	setup_display();
 
 	// Start up is an automatic transition
@@ -0,0 +1,72 @@
+/* prng.c
+
+xorshift32 (13, 17, 5) generator, returning the
+high half of the state. Ranges are reduced with
+Lemire's multiply-shift and a rejection step, so
+every value in a range is equally likely and no
+division happens except on the rare retry path.
+
+The state is reseeded from ADC noise and a boot
+counter kept in EEPROM, so each night gets a
+different show even if the noise repeats.
+
+ */
+
+#include <stdint.h>
+#include <avr/io.h>
+#include <avr/eeprom.h>
+#include "prng.h"
+
+static uint32_t prngState = PRNG_DEFAULT_SEED;
+
+// seeds handed out so far, survives power loss
+static uint16_t EEMEM prngSeedCount;
+
+
+// Mix noise and the persisted counter into the state
+void prng_seed(uint16_t noise){
+
+	uint16_t count = eeprom_read_word(&prngSeedCount) + 1;
+	eeprom_update_word(&prngSeedCount, count);
+
+	prngState ^= ((uint32_t)count << 16) | noise;
+
+	// xorshift never leaves zero
+	if(!prngState){
+		prngState = PRNG_DEFAULT_SEED;
+	}
+
+	// spread the new bits through the whole state
+	for(uint8_t i = 0; i < 8; i++){
+		prng_next();
+	}
+}
+
+// Next 16 random bits
+uint16_t prng_next(void){
+
+	uint32_t x = prngState;
+
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	prngState = x;
+
+	return x >> 16;
+}
+
+// Uniform value in [0, range), 0 when range is 0
+uint16_t prng_range(uint16_t range){
+
+	uint32_t m = (uint32_t)prng_next() * range;
+
+	// low half below 2^16 mod range means this value is over-represented
+	if((uint16_t)m < range){
+		uint16_t threshold = (uint16_t)(-range) % range;
+		while((uint16_t)m < threshold){
+			m = (uint32_t)prng_next() * range;
+		}
+	}
+
+	return m >> 16;
+}
@@ -0,0 +1,19 @@
+#ifndef PRNG_H
+#define PRNG_H
+
+/*
+ * prng.h
+ *
+ * Integer random numbers for the display.
+ *
+ */
+
+// Starting state until prng_seed is called, any nonzero value
+#define PRNG_DEFAULT_SEED 0x2545F491UL
+
+// Function Prototypes
+void prng_seed(uint16_t noise);
+uint16_t prng_next(void);
+uint16_t prng_range(uint16_t range);
+
+#endif // PRNG_H
@@ -0,0 +1,114 @@
+#!/usr/bin/env python3
+#
+# fadegen.py
+#
+# Generates the gamma corrected fade curves used by display.c
+#
+#   python3 tools/fadegen.py [--gamma G] [--max M] [--out DIR] STEPS...
+#
+# Run from SolarOne/, e.g. "python3 tools/fadegen.py --gamma 2.2 60 100 120 150 200"
+# rewrites src/fades.h and src/fades.c. Curve k of the output is the k-th
+# STEPS argument, and its id is what draw_params() in display.c selects.
+# Steps are timeline ticks of DISPLAY_STEP_US, see display.h.
+#
+# Brightness after i of n steps is FADE_MAX * (i / n) ^ gamma. Each curve is
+# stored as n 8-bit deltas between consecutive levels, scaled down by a per
+# curve shift chosen so the largest delta fits in a byte. Levels are rounded
+# before differencing, so summing the deltas never drifts from the curve, and
+# FADE_MAX is trimmed to a multiple of the largest shift so every curve ends
+# on exactly the same peak.
+#
+# Every FADE_MARK_STEPS steps the full level is also stored in fadeMarks, so
+# any step of a curve is one mark plus at most FADE_MARK_STEPS - 1 deltas.
+
+import argparse
+import os
+
+MARK_STEPS = 8
+
+
+def quantize(steps, gamma, peak, shift):
+	top = peak >> shift
+	return [min(top, int(round(top * (i / steps) ** gamma))) for i in range(steps + 1)]
+
+
+def curve_shift(steps, gamma, peak):
+	for shift in range(16):
+		q = quantize(steps, gamma, peak, shift)
+		if max(b - a for a, b in zip(q, q[1:])) <= 0xFF:
+			return shift
+	raise ValueError("no shift fits %d steps" % steps)
+
+
+def main():
+	parser = argparse.ArgumentParser(description="Generate compressed PROGMEM fade curves")
+	parser.add_argument("--gamma", type=float, default=2.2, help="curve exponent, 1.0 is linear")
+	parser.add_argument("--max", type=lambda s: int(s, 0), default=0xFF78, help="requested peak PWM value")
+	parser.add_argument("--out", default="src", help="directory for fades.h and fades.c")
+	parser.add_argument("steps", type=int, nargs="+", help="fade durations in ticks, 1..255")
+	args = parser.parse_args()
+
+	for n in args.steps:
+		if not 1 <= n <= 255:
+			parser.error("fade durations must be 1..255 ticks")
+
+	shifts = [curve_shift(n, args.gamma, args.max) for n in args.steps]
+	peak = (args.max >> max(shifts)) << max(shifts)
+	marks = [(n + MARK_STEPS - 1) // MARK_STEPS for n in args.steps]
+	if sum(marks) > 256:
+		parser.error("too many fade steps for 8-bit mark offsets")
+	command = "fadegen.py --gamma %g --max 0x%04X %s" % (args.gamma, args.max, " ".join(map(str, args.steps)))
+
+	with open(os.path.join(args.out, "fades.h"), "w") as h:
+		h.write("#ifndef FADES_H\n#define FADES_H\n\n")
+		h.write("/*\n * fades.h\n *\n * Generated by %s, do not edit\n *\n */\n\n" % command)
+		h.write("#include <avr/pgmspace.h>\n\n")
+		h.write("#define NUM_FADES %d\t\t\t\t\t\t\t\t// Number of fade curves, ids 0..NUM_FADES-1\n" % len(args.steps))
+		h.write("#define FADE_MAX 0x%04X\t\t\t\t\t\t\t// Peak of every curve\n" % peak)
+		h.write("#define FADE_DATA_BYTES %d\t\t\t\t\t\t// Bytes of deltas in fadeDeltas\n" % sum(args.steps))
+		h.write("#define FADE_MARK_STEPS %d\t\t\t\t\t\t// Steps between stored levels in fadeMarks\n" % MARK_STEPS)
+		h.write("#define FADE_MARKS %d\t\t\t\t\t\t\t// Levels in fadeMarks\n\n" % sum(marks))
+		h.write("// One compressed curve: level i + 1 = level i + (delta i << shift), and\n")
+		h.write("// level i * FADE_MARK_STEPS is stored whole at fadeMarks[mark + i]\n")
+		h.write("typedef struct{\n\n")
+		h.write("\tuint16_t offset;\t\t\t// first delta in fadeDeltas\n")
+		h.write("\tuint8_t steps;\t\t\t\t// fade duration, in ticks of DISPLAY_STEP_US\n")
+		h.write("\tuint8_t shift;\t\t\t\t// scale of the deltas\n")
+		h.write("\tuint8_t mark;\t\t\t\t// first level in fadeMarks\n\n")
+		h.write("}fade_curve;\n\n")
+		h.write("extern const fade_curve fadeCurves[NUM_FADES] PROGMEM;\n")
+		h.write("extern const uint8_t fadeDeltas[FADE_DATA_BYTES] PROGMEM;\n")
+		h.write("extern const uint16_t fadeMarks[FADE_MARKS] PROGMEM;\n\n")
+		h.write("#endif // FADES_H\n")
+
+	with open(os.path.join(args.out, "fades.c"), "w") as c:
+		c.write("/*\n * fades.c\n *\n * Generated by %s, do not edit\n *\n */\n\n" % command)
+		c.write("#include \"fades.h\"\n\n")
+		c.write("const fade_curve fadeCurves[NUM_FADES] PROGMEM = {\n")
+		offset = 0
+		mark = 0
+		for n, shift, m in zip(args.steps, shifts, marks):
+			c.write("\t{%d, %d, %d, %d},\n" % (offset, n, shift, mark))
+			offset += n
+			mark += m
+		c.write("};\n\n")
+		c.write("const uint8_t fadeDeltas[FADE_DATA_BYTES] PROGMEM = {\n")
+		for n, shift in zip(args.steps, shifts):
+			q = quantize(n, args.gamma, peak, shift)
+			deltas = [b - a for a, b in zip(q, q[1:])]
+			c.write("\n\t// %d steps, << %d\n" % (n, shift))
+			for i in range(0, n, 12):
+				c.write("\t" + " ".join("0x%02X," % d for d in deltas[i:i + 12]) + "\n")
+		c.write("\n};\n\n")
+		c.write("const uint16_t fadeMarks[FADE_MARKS] PROGMEM = {\n")
+		for n, shift in zip(args.steps, shifts):
+			q = quantize(n, args.gamma, peak, shift)
+			c.write("\n\t// %d steps, every %d\n" % (n, MARK_STEPS))
+			levels = [q[i] << shift for i in range(0, n, MARK_STEPS)]
+			for i in range(0, len(levels), 8):
+				c.write("\t" + " ".join("0x%04X," % v for v in levels[i:i + 8]) + "\n")
+		c.write("\n};\n")
+
+
+if __name__ == "__main__":
+	main()
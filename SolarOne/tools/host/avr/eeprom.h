@@ -0,0 +1,11 @@
+/* Host stand-in for <avr/eeprom.h> */
+#ifndef HOST_AVR_EEPROM_H
+#define HOST_AVR_EEPROM_H
+
+#include <stdint.h>
+
+#define EEMEM
+static inline uint16_t eeprom_read_word(const uint16_t *p){ return *p; }
+static inline void eeprom_update_word(uint16_t *p, uint16_t v){ *p = v; }
+
+#endif
@@ -0,0 +1,9 @@
+/* Host stand-in for <avr/interrupt.h>, ISRs become plain functions */
+#ifndef HOST_AVR_INTERRUPT_H
+#define HOST_AVR_INTERRUPT_H
+
+#define cli()
+#define sei()
+#define ISR(vector) void vector(void)
+
+#endif
@@ -0,0 +1,80 @@
+/* Host stand-in for <avr/io.h>: the ATmega328P registers used by the
+   firmware, as plain variables defined in avr_regs.c. */
+#ifndef HOST_AVR_IO_H
+#define HOST_AVR_IO_H
+
+#include <stdint.h>
+
+#define AVR_REGISTERS(R) \
+	R(PORTB) R(PORTC) R(PORTD) R(DDRB) R(DDRC) R(DDRD) R(SREG) R(MCUSR) R(WDTCSR) \
+	R(TCCR0A) R(TCCR0B) R(TCNT0) R(TIFR0) R(TIMSK0) R(TCCR1B) R(TIMSK1) \
+	R(TCCR2A) R(TCCR2B) R(TCNT2) R(TIFR2) R(SPCR) R(SPSR) R(SPDR) \
+	R(UCSR0A) R(UCSR0B) R(UCSR0C) R(UDR0) R(ADMUX) R(ADCSRA)
+
+#define AVR_DECLARE(r) extern volatile uint8_t r;
+AVR_REGISTERS(AVR_DECLARE)
+extern volatile uint16_t OCR1A, UBRR0, ADC;
+
+#define _BV(bit) (1 << (bit))
+#define bit_is_set(reg, bit) ((reg) & _BV(bit))
+#define loop_until_bit_is_set(reg, bit) do{}while(0)
+
+#define RAMSTART 0x100
+#define RAMEND 0x8FF
+
+#define PB0 0
+#define PB3 3
+#define PB4 4
+#define PB5 5
+#define DDB2 2
+#define DDB3 3
+#define DDB4 4
+#define DDB5 5
+#define DDD1 1
+#define DDD4 4
+#define PORTD2 2
+#define PORTD3 3
+#define PORTD4 4
+#define PORTD5 5
+#define PORTD6 6
+#define PORTD7 7
+#define CS00 0
+#define CS01 1
+#define CS02 2
+#define CS10 0
+#define CS12 2
+#define CS20 0
+#define CS21 1
+#define CS22 2
+#define TOV0 0
+#define TOV2 0
+#define TOIE0 0
+#define OCIE1A 1
+#define WGM12 3
+#define SPR0 0
+#define SPR1 1
+#define MSTR 4
+#define SPE 6
+#define SPIE 7
+#define SPI2X 0
+#define SPIF 7
+#define TXC0 6
+#define UDRE0 5
+#define TXCIE0 6
+#define TXEN0 3
+#define UMSEL00 6
+#define UMSEL01 7
+#define REFS0 6
+#define ADPS0 0
+#define ADPS1 1
+#define ADPS2 2
+#define ADSC 6
+#define ADEN 7
+#define WDRF 3
+#define WDP0 0
+#define WDE 3
+#define WDCE 4
+#define WDP3 5
+#define WDIE 6
+
+#endif
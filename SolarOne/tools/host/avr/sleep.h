@@ -0,0 +1,6 @@
+/* Host stand-in for <avr/sleep.h> */
+#define SLEEP_MODE_PWR_DOWN 2
+#define set_sleep_mode(mode)
+#define sleep_enable()
+#define sleep_disable()
+#define sleep_cpu()
@@ -0,0 +1 @@
+/* Host stand-in for <avr/wdt.h> */
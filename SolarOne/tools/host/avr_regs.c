@@ -0,0 +1,33 @@
+/* avr_regs.c
+
+The ATmega328P registers declared in avr/io.h, as plain
+variables, and stand-ins for the library calls that only
+exist on the target: avr-libc's utoa() and the uart
+library (uart.c only builds for a real MCU). Linked with
+main.c, TLC59711.c and clock.c to check that the whole
+firmware links, not to run it.
+
+ */
+
+#include <stdio.h>
+#include <avr/io.h>
+#include "uart.h"
+
+#define AVR_DEFINE(r) volatile uint8_t r;
+AVR_REGISTERS(AVR_DEFINE)
+volatile uint16_t OCR1A, UBRR0, ADC;
+
+
+char *utoa(unsigned int value, char *s, int radix){
+	(void)radix;
+	sprintf(s, "%u", value);
+	return s;
+}
+
+void uart_init(unsigned int baudrate){
+	(void)baudrate;
+}
+
+void uart_puts(const char *s){
+	fputs(s, stdout);
+}
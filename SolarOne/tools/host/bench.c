@@ -0,0 +1,93 @@
+/* bench.c
+
+Host timing of update_display(). Runs one tick per frame
+with a stall of stall ticks every period frames, and
+prints the frame time percentiles in ns, the mean time of
+the stall frames, the most channels taken from the pool
+in one frame and the lit leds per frame.
+
+	bench [frames] [period] [stall]
+
+Timings are the host's, only useful relative to each other.
+
+ */
+
+#include <stdio.h>
+#include <time.h>
+#include "display.h"
+
+static uint32_t frameNs[1000000];
+
+
+static int by_value(const void *a, const void *b){
+	uint32_t x = *(const uint32_t *)a;
+	uint32_t y = *(const uint32_t *)b;
+	return (x > y) - (x < y);
+}
+
+
+static uint32_t now_ns(void){
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec * 1000000000UL + t.tv_nsec;
+}
+
+
+int main(int argc, char **argv){
+
+	long frames = (argc > 1) ? atol(argv[1]) : 1000000;
+	long period = (argc > 2) ? atol(argv[2]) : 5000;
+	uint16_t stall = (argc > 3) ? atol(argv[3]) : 300;
+	long timed = 0, stalls = 0, lit = 0;
+	double stallNs = 0;
+	int maxPicks = 0;
+
+	if(frames > 1000000){
+		frames = 1000000;
+	}
+
+	setup_display();
+	clear_leds();
+	display_init();
+
+	for(long f = 0; f < frames; f++){
+
+		uint16_t ticks = (f % period == period - 1) ? stall : 1;
+		uint8_t before[POOL_BYTES];
+		int picks = 0;
+
+		memcpy(before, ledPool, POOL_BYTES);
+
+		uint32_t begin = now_ns();
+		update_display(displayTick + ticks, 0);
+		uint32_t ns = now_ns() - begin;
+
+		display_idle();
+
+		if(ticks > 1){
+			stallNs += ns;
+			stalls++;
+		}
+
+		else{
+			frameNs[timed++] = ns;
+		}
+
+		for(channel_t c = 0; c < TOTAL_CHANNELS; c++){
+			if(POOL_TAKEN(c) && !(before[c >> 3] & (1 << (c & 7)))) picks++;
+			if(CHANNEL_VALUE(c)) lit++;
+		}
+
+		if(picks > maxPicks){
+			maxPicks = picks;
+		}
+	}
+
+	qsort(frameNs, timed, sizeof(frameNs[0]), by_value);
+
+	printf("%d drivers, %d active, budget %d: p50 %u p99 %u p99.9 %u ns, stall frame %.0f ns, max picks %d, lit %.1f\n",
+		   NUM_DRIVERS, ACTIVE_LEDS, DISPLAY_FRAME_BUDGET, frameNs[timed / 2], frameNs[timed * 99 / 100],
+		   frameNs[timed * 999 / 1000], stalls ? stallNs / stalls : 0, maxPicks, (double)lit / frames);
+
+	return 0;
+}
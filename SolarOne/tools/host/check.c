@@ -0,0 +1,198 @@
+/* check.c
+
+Host check of the display timeline. Runs update_display()
+over a scripted night and after every frame checks that
+each active led is filed exactly once, under the stage
+led_state() gives it, with its channel showing the
+brightness led_state() gives it, and that the pool agrees.
+
+	check [frames] [gap]
+
+Every 50th frame or so skips up to gap ticks (default 1,
+no skips). Also checks fade_level() against the summed
+deltas, and that the channel values at a given millisecond
+do not depend on the frame period.
+
+ */
+
+#include <stdio.h>
+#include "display.h"
+
+// built in, so each run can restart the generator from the same state
+#include "prng.c"
+
+extern uint16_t hostMillis;
+
+static int where[TOTAL_CHANNELS];
+static int ended[TOTAL_CHANNELS];
+
+
+static int fail(const char *what, long frame, int channel){
+	printf("FAIL %s, frame %ld channel %d\n", what, frame, channel);
+	return 1;
+}
+
+
+// Every step of every curve is its mark plus the deltas since, and every curve ends on FADE_MAX
+static int check_fades(void){
+
+	for(uint8_t c = 0; c < NUM_FADES; c++){
+
+		uint16_t level = 0;
+
+		for(uint8_t i = 0; i < FADE_STEPS(c); i++){
+			if(fade_level(c, i, 0) != level || fade_level(c, i, 256) != level + FADE_DELTA(c, i)){
+				return fail("fade_level", i, c);
+			}
+			level += FADE_DELTA(c, i);
+		}
+
+		if(level != FADE_MAX){
+			return fail("fade peak", 0, c);
+		}
+	}
+
+	return 0;
+}
+
+
+// Invariants after update_display(displayTick, frac)
+static int check_frame(long f, uint8_t frac){
+
+	uint16_t brightness;
+	int taken = 0;
+
+	memset(where, 0, sizeof(where));
+	memset(ended, 0, sizeof(ended));
+
+	for(uint8_t s = 0; s < DISPLAY_WHEEL_SLOTS; s++){
+		for(channel_t c = wheelHead[s]; c != NO_CHANNEL; c = ledNext[c]){
+			uint8_t stage = led_state(c, displayTick, frac, &brightness);
+			where[c]++;
+			if((ledDeadline[c] & WHEEL_MASK) != s) return fail("wrong wheel slot", f, c);
+			if((int16_t)(ledDeadline[c] - displayTick) <= 0) return fail("overdue in wheel", f, c);
+			if(stage != startDelay && stage != hold) return fail("wheel stage", f, c);
+		}
+	}
+
+	for(channel_t i = 0; i < fadeInCount; i++){
+		where[fadeInLEDs[i]]++;
+		if(led_state(fadeInLEDs[i], displayTick, frac, &brightness) != fadeIn) return fail("fade in stage", f, fadeInLEDs[i]);
+	}
+
+	for(channel_t i = 0; i < fadeOutCount; i++){
+		where[fadeOutLEDs[i]]++;
+		if(led_state(fadeOutLEDs[i], displayTick, frac, &brightness) != fadeOut) return fail("fade out stage", f, fadeOutLEDs[i]);
+	}
+
+	// put off replacements stay dark until they are made
+	for(channel_t i = 0; i < endedCount; i++){
+		where[endedLEDs[i]]++;
+		ended[endedLEDs[i]] = 1;
+		if(CHANNEL_VALUE(endedLEDs[i])) return fail("ended led lit", f, endedLEDs[i]);
+	}
+
+	for(channel_t c = 0; c < TOTAL_CHANNELS; c++){
+
+		if(where[c] > 1) return fail("filed twice", f, c);
+		if(!!POOL_TAKEN(c) != where[c]) return fail("pool disagrees", f, c);
+		taken += where[c];
+
+		if(!where[c] && CHANNEL_VALUE(c)) return fail("inactive led lit", f, c);
+
+		if(where[c] && !ended[c]){
+			led_state(c, displayTick, frac, &brightness);
+			if(brightness != CHANNEL_VALUE(c)) return fail("brightness", f, c);
+		}
+	}
+
+	for(uint16_t c = TOTAL_CHANNELS; c < 8 * POOL_BYTES; c++){
+		if(!POOL_TAKEN(c)) return fail("pool tail free", f, c);
+	}
+
+	if(taken != activeCount) return fail("activeCount", f, taken);
+
+	return 0;
+}
+
+
+// Channel values sampled every 42ms must match whatever the frame period
+static int check_periods(void){
+
+	static uint16_t samples[3][30][TOTAL_CHANNELS];
+	const uint8_t periods[3] = {2, 6, 21};
+
+	for(uint8_t p = 0; p < 3; p++){
+
+		prngState = PRNG_DEFAULT_SEED;
+		hostMillis = 1000;
+		clear_leds();
+		display_init();
+
+		for(uint16_t t = 0; t < 30 * 42; t += periods[p]){
+			hostMillis = 1000 + t;
+			write_display();
+			if(t % 42 == 0){
+				for(channel_t c = 0; c < TOTAL_CHANNELS; c++){
+					samples[p][t / 42][c] = CHANNEL_VALUE(c);
+				}
+			}
+		}
+	}
+
+	for(uint8_t i = 0; i < 30; i++){
+		for(channel_t c = 0; c < TOTAL_CHANNELS; c++){
+			if(samples[0][i][c] != samples[1][i][c] || samples[0][i][c] != samples[2][i][c]){
+				return fail("frame period changed a channel", i, c);
+			}
+		}
+	}
+
+	return 0;
+}
+
+
+int main(int argc, char **argv){
+
+	long frames = (argc > 1) ? atol(argv[1]) : 200000;
+	long gap = (argc > 2) ? atol(argv[2]) : 1;
+	long lit = 0;
+
+	setup_display();
+
+	if(check_fades() || check_periods()){
+		return 1;
+	}
+
+	// as main.c leaves it after a night
+	clear_leds();
+	display_init();
+	srand(7);
+
+	for(long f = 0; f < frames; f++){
+
+		// drop the target and bring it back while running
+		if(f == frames / 4) set_active_leds(ACTIVE_LEDS / 4);
+		if(f == frames * 2 / 5) set_active_leds(0);
+		if(f == frames / 2) set_active_leds(ACTIVE_LEDS / 2);
+		if(f == frames * 3 / 4) set_active_leds(ACTIVE_LEDS);
+
+		uint16_t ticks = (gap > 1 && rand() % 50 == 0) ? 1 + rand() % gap : 1;
+		uint8_t frac = rand();
+
+		update_display(displayTick + ticks, frac);
+		display_idle();
+
+		if(check_frame(f, frac)){
+			return 1;
+		}
+
+		for(channel_t c = 0; c < TOTAL_CHANNELS; c++){
+			if(CHANNEL_VALUE(c)) lit++;
+		}
+	}
+
+	printf("ok %d drivers, %ld frames, lit per frame %.2f\n", NUM_DRIVERS, frames, (double)lit / frames);
+
+	return 0;
+}
@@ -0,0 +1,54 @@
+#!/bin/sh
+#
+# check.sh
+#
+# Builds the firmware sources against the stand-in AVR headers in
+# tools/host and runs the display checks on the host.
+#
+#   sh tools/host/check.sh
+#
+# Run from SolarOne/. Compiles every source (but uart.c, which only knows
+# real MCUs) warning-free for each SPI backend and links the firmware
+# against avr_regs.c, then runs check.c at a few chain sizes, with and
+# without skipped ticks. bench.c times
+# update_display(), e.g.
+#
+#   gcc -O2 -include tools/host/host.h -Itools/host -Isrc \
+#       -DSPI_BACKEND=SPI_BACKEND_HARDWARE -DNUM_DRIVERS=32 -DACTIVE_LEDS=192 -o bench \
+#       tools/host/bench.c tools/host/host.c src/display.c src/fades.c src/prng.c
+#   ./bench 1000000 5000 300
+
+set -e
+
+CC=${CC:-gcc}
+HOST="-std=gnu99 -Wall -Wextra -Werror -fno-common -include tools/host/host.h -Itools/host -Isrc"
+OUT=$(mktemp -d)
+trap 'rm -rf "$OUT"' EXIT
+
+for backend in BITBANG HARDWARE USART PARALLEL; do
+	for file in main TLC59711 clock display fades prng; do
+		$CC $HOST -DSPI_BACKEND=SPI_BACKEND_$backend -DSPI_PROFILE -DDISPLAY_PROFILE -fsyntax-only src/$file.c
+	done
+done
+echo "sources build with every backend"
+
+# the whole firmware links, registers and uart from avr_regs.c
+for backend in BITBANG HARDWARE USART PARALLEL; do
+	$CC -O2 $HOST -DSPI_BACKEND=SPI_BACKEND_$backend -DSPI_PROFILE -DDISPLAY_PROFILE -o "$OUT/firmware" \
+		src/main.c src/TLC59711.c src/clock.c src/display.c src/fades.c src/prng.c tools/host/avr_regs.c
+done
+echo "firmware links with every backend"
+
+# chains past 7 drivers need a faster transport than bit-bang, see display.h
+run(){
+	$CC -O2 $HOST -DSPI_BACKEND=SPI_BACKEND_HARDWARE "$@" -o "$OUT/check" \
+		tools/host/check.c tools/host/host.c src/display.c src/fades.c
+	"$OUT/check" 200000 1
+	"$OUT/check" 200000 400
+}
+
+run -DNUM_DRIVERS=2
+run -DNUM_DRIVERS=3 -DDISPLAY_FRAME_BUDGET=1
+run -DNUM_DRIVERS=21
+run -DNUM_DRIVERS=32 -DACTIVE_LEDS=192
+run -DNUM_DRIVERS=2 -fsanitize=address,undefined
@@ -0,0 +1,45 @@
+/* host.c
+
+Stand-ins for the transport and the Timer0 clock, so
+display.c can run on a host. Frames are copied to
+sentFrame instead of shifted out, and clock_ms()
+returns hostMillis, which the driver advances.
+
+ */
+
+#include <string.h>
+#include "display.h"
+
+uint8_t sentFrame[FRAME_BYTES];
+uint16_t hostMillis;
+volatile uint8_t spiTransferComplete = 1;
+
+
+void spi_init(void){
+}
+
+void spi_write(uint8_t *frame, uint16_t length){
+	memcpy(sentFrame, frame, length);
+}
+
+void spi_write_async(uint8_t *frame, uint16_t length){
+	memcpy(sentFrame, frame, length);
+}
+
+void spi_wait(void){
+}
+
+// Placeholder header bytes, only blanking is told apart
+void spi_set_header(uint8_t *frame, uint8_t numDrivers, uint8_t blank){
+	for(uint8_t n = 0; n < numDrivers; n++, frame += SPI_BYTES_PER_DRIVER){
+		memset(frame, blank ? 0xFF : 0x00, 4);
+	}
+}
+
+uint16_t clock_ms(void){
+	return hostMillis;
+}
+
+uint16_t clock_ticks(void){
+	return 0;
+}
@@ -0,0 +1,19 @@
+/* host.h
+
+Forced into every host build (-include). Declares the
+avr-libc extras the firmware uses that a host libc lacks,
+and what the host drivers read back from the display.
+
+ */
+
+#ifndef HOST_H
+#define HOST_H
+
+#include <stdint.h>
+
+char *utoa(unsigned int value, char *s, int radix);
+
+// Value last rendered into a channel's slot in backFrame, for the host drivers
+#define CHANNEL_VALUE(channel) ((uint16_t)(backFrame[SPI_SLOT(channel)] << 8) | backFrame[SPI_SLOT(channel) + 1])
+
+#endif // HOST_H
@@ -0,0 +1,3 @@
+/* Host stand-in for <util/delay.h>, delays take no time */
+#define _delay_us(us)
+#define _delay_ms(ms)
@@ -0,0 +1 @@
+/* Host stand-in for <util/delay_basic.h> */